@@ -0,0 +1,299 @@
+#pragma once
+
+// Small-buffer type erasure for arbitrary interfaces: the technique of acpp::function,
+// generalized from a single operator() to any set of operations. Each operation names its
+// signature, with acpp::self standing for the erased object, and how to perform it on a
+// concrete type:
+//
+//     struct area {
+//         using signature = double(const acpp::self&);
+//         static double call(const auto& shape) { return shape.area(); }
+//     };
+//     struct scale {
+//         using signature = void(acpp::self&, double);
+//         static void call(auto& shape, double k) { shape.scale(k); }
+//     };
+//     using shape = acpp::any_of<acpp::interface<area, scale>>;
+//
+//     shape s = circle{1.0};
+//     double a = s.call<area>();
+//
+// Objects that fit InlineBytes and move without throwing live inside the wrapper, the rest go
+// through Spill like large callables do. Every stored type gets one constexpr vtable with
+// destroy, copy, move and an entry per operation, so a call is one load from the wrapper and
+// one indirect call, with no pointer chase for inline objects.
+//
+// acpp::function keeps an engine of its own: its single operation's pointer sits in the
+// object, which saves that load on every call. The other erased types of the library build
+// on this one: uring_file_io completions are unique_any_of, async_logger records use pinned
+// vtables (_Any_pinned_model) and state_machine cells call through its thunks.
+
+#include <concepts>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "function.h"
+
+namespace acpp {
+
+/// Stands for the erased object in operation signatures
+struct self;
+
+/// The operations an any_of supports, in the order of its vtable
+template <typename... Operations>
+struct interface {};
+
+namespace detail {
+
+template <typename Signature>
+struct _Operation_traits;
+
+template <typename R, typename... Args>
+struct _Operation_traits<R(self&, Args...)> {
+    static constexpr bool is_const = false;
+    using pointer = R (*)(void*, Args...);
+    template <typename Op, typename T>
+    static constexpr bool supports = requires(T& object, Args&&... args) {
+        { Op::call(object, std::forward<Args>(args)...) } -> std::convertible_to<R>;
+    };
+};
+
+template <typename R, typename... Args>
+struct _Operation_traits<R(const self&, Args...)> {
+    static constexpr bool is_const = true;
+    using pointer = R (*)(const void*, Args...);
+    template <typename Op, typename T>
+    static constexpr bool supports = requires(const T& object, Args&&... args) {
+        { Op::call(object, std::forward<Args>(args)...) } -> std::convertible_to<R>;
+    };
+};
+
+template <typename T, typename... Operations>
+concept _Implements = (_Operation_traits<typename Operations::signature>::template supports<Operations, T> && ...);
+
+template <typename Op, typename First, typename... Rest>
+constexpr std::size_t _Operation_index() noexcept {
+    if constexpr (std::is_same_v<Op, First>) {
+        return 0;
+    } else {
+        static_assert(sizeof...(Rest) > 0, "operation is not part of this interface");
+        return 1 + _Operation_index<Op, Rest...>();
+    }
+}
+
+// Same rules as _In_place_callable, for a buffer of InlineBytes
+template <typename T, std::size_t InlineBytes>
+concept _In_place_object = sizeof(T) <= InlineBytes &&
+                           alignof(void*) % alignof(T) == 0 &&
+                           std::is_nothrow_move_constructible<T>::value;
+
+// The stored object, from the address of the wrapper's buffer
+template <typename T, bool Inline>
+struct _Any_object {
+    static T& get(void* storage) noexcept {
+        if constexpr (Inline) {
+            return *std::launder(static_cast<T*>(storage));
+        } else {
+            return **static_cast<T**>(storage);
+        }
+    }
+    static const T& get(const void* storage) noexcept { return get(const_cast<void*>(storage)); }
+};
+
+template <typename Op, typename Object, typename Signature = typename Op::signature>
+struct _Any_thunk;
+
+template <typename Op, typename Object, typename R, typename... Args>
+struct _Any_thunk<Op, Object, R(self&, Args...)> {
+    static R call(void* storage, Args... args) { return Op::call(Object::get(storage), std::forward<Args>(args)...); }
+};
+
+template <typename Op, typename Object, typename R, typename... Args>
+struct _Any_thunk<Op, Object, R(const self&, Args...)> {
+    static R call(const void* storage, Args... args) {
+        return Op::call(Object::get(storage), std::forward<Args>(args)...);
+    }
+};
+
+/// Acts like a virtual table; copy is null for move-only wrappers
+template <typename... Operations>
+struct _Any_vtable {
+    void (*destroy)(void* storage) noexcept;
+    void (*copy)(void* dst, const void* src);
+    void (*move)(void* dst, void* src) noexcept;
+    std::tuple<typename _Operation_traits<typename Operations::signature>::pointer...> operations;
+};
+
+template <typename T, std::size_t InlineBytes, typename Spill, bool Copyable, typename... Operations>
+struct _Any_model {
+    static constexpr bool is_inline = _In_place_object<T, InlineBytes>;
+    using _Object = _Any_object<T, is_inline>;
+
+    template <typename... CtorArgs>
+    static void create(void* storage, CtorArgs&&... args) {
+        if constexpr (is_inline) {
+            new (storage) T(std::forward<CtorArgs>(args)...);
+        } else {
+            *static_cast<T**>(storage) = Spill::template create<T>(std::forward<CtorArgs>(args)...);
+        }
+    }
+    static void destroy(void* storage) noexcept {
+        if constexpr (is_inline) {
+            _Object::get(storage).~T();
+        } else {
+            Spill::destroy(&_Object::get(storage));
+        }
+    }
+    static void copy(void* dst, const void* src) { create(dst, _Object::get(src)); }
+    static void move(void* dst, void* src) noexcept {
+        if constexpr (is_inline) {
+            new (dst) T(std::move(_Object::get(src)));
+            _Object::get(src).~T();
+        } else {
+            *static_cast<T**>(dst) = *static_cast<T**>(src);
+        }
+    }
+    // Only taken for copyable wrappers, so move-only types never instantiate copy
+    static constexpr void (*copy_entry() noexcept)(void*, const void*) {
+        if constexpr (Copyable) { return &copy; } else { return nullptr; }
+    }
+
+    static constexpr _Any_vtable<Operations...> vtable{
+        &destroy, copy_entry(), &move, {&_Any_thunk<Operations, _Object>::call...}};
+};
+
+// Vtable for objects that never leave the place they were built in, such as records in a
+// ring buffer: no copy or move, only destroy and the operations
+template <typename T, typename... Operations>
+struct _Any_pinned_model {
+    using _Object = _Any_object<T, true>;
+
+    static void destroy(void* storage) noexcept { _Object::get(storage).~T(); }
+
+    static constexpr _Any_vtable<Operations...> vtable{
+        &destroy, nullptr, nullptr, {&_Any_thunk<Operations, _Object>::call...}};
+};
+
+} // namespace detail
+
+template <typename Interface, std::size_t InlineBytes = 16, typename Spill = heap_spill, bool Copyable = true>
+class basic_any_of;
+
+/// Copyable value with the operations of Interface
+template <typename Interface, std::size_t InlineBytes = 16, typename Spill = heap_spill>
+using any_of = basic_any_of<Interface, InlineBytes, Spill, true>;
+
+/// Move-only variant; accepts move-only types
+template <typename Interface, std::size_t InlineBytes = 16, typename Spill = heap_spill>
+using unique_any_of = basic_any_of<Interface, InlineBytes, Spill, false>;
+
+template <typename... Operations, std::size_t InlineBytes, typename Spill, bool Copyable>
+class basic_any_of<interface<Operations...>, InlineBytes, Spill, Copyable> {
+private:
+    static_assert(InlineBytes >= sizeof(void*), "the buffer must be able to hold a spill pointer");
+    using _Vtable = detail::_Any_vtable<Operations...>;
+    template <typename T>
+    using _Model = detail::_Any_model<T, InlineBytes, Spill, Copyable, Operations...>;
+
+    template <typename T>
+    static constexpr bool _Storable = detail::_Implements<T, Operations...> &&
+                                      (!Copyable || std::is_copy_constructible_v<T>) &&
+                                      !std::is_same_v<T, basic_any_of>;
+
+public:
+    /// Whether T is stored in the wrapper rather than through Spill
+    template <typename T>
+    static constexpr bool is_inline = detail::_In_place_object<T, InlineBytes>;
+
+    basic_any_of() noexcept = default;
+
+    template <typename T>
+        requires _Storable<std::decay_t<T>>
+    basic_any_of(T&& object) { emplace<std::decay_t<T>>(std::forward<T>(object)); }
+
+    template <typename T, typename... CtorArgs>
+        requires _Storable<T>
+    explicit basic_any_of(std::in_place_type_t<T>, CtorArgs&&... args) {
+        emplace<T>(std::forward<CtorArgs>(args)...);
+    }
+
+    basic_any_of(const basic_any_of& oth) requires Copyable {
+        if (oth) {
+            oth.vtable_->copy(storage_, oth.storage_);
+            vtable_ = oth.vtable_;
+        }
+    }
+    basic_any_of(const basic_any_of&) requires (!Copyable) = delete;
+
+    basic_any_of(basic_any_of&& oth) noexcept {
+        if (oth) {
+            oth.vtable_->move(storage_, oth.storage_);
+            vtable_ = std::exchange(oth.vtable_, nullptr);
+        }
+    }
+
+    basic_any_of& operator=(basic_any_of oth) noexcept { swap(oth); return *this; }
+
+    ~basic_any_of() { reset(); }
+
+    /// Replaces the stored object with a T built in place
+    template <typename T, typename... CtorArgs>
+        requires _Storable<T>
+    T& emplace(CtorArgs&&... args) {
+        reset();
+        _Model<T>::create(storage_, std::forward<CtorArgs>(args)...);
+        vtable_ = &_Model<T>::vtable;
+        return _Model<T>::_Object::get(storage_);
+    }
+
+    void reset() noexcept {
+        if (vtable_) {
+            vtable_->destroy(storage_);
+            vtable_ = nullptr;
+        }
+    }
+
+    explicit operator bool() const noexcept { return vtable_ != nullptr; }
+
+    template <typename Op, typename... Args>
+    decltype(auto) call(Args&&... args) {
+        if (!vtable_) { throw std::runtime_error("bad any_of call"); }
+        return std::get<detail::_Operation_index<Op, Operations...>()>(vtable_->operations)(
+            storage_, std::forward<Args>(args)...);
+    }
+
+    template <typename Op, typename... Args>
+    decltype(auto) call(Args&&... args) const {
+        static_assert(detail::_Operation_traits<typename Op::signature>::is_const,
+                      "operation takes acpp::self&, call it on a non-const any_of");
+        if (!vtable_) { throw std::runtime_error("bad any_of call"); }
+        return std::get<detail::_Operation_index<Op, Operations...>()>(vtable_->operations)(
+            storage_, std::forward<Args>(args)...);
+    }
+
+    /// The stored object if it is a T, otherwise null
+    template <typename T>
+    T* target() noexcept {
+        return vtable_ == &_Model<T>::vtable ? &_Model<T>::_Object::get(storage_) : nullptr;
+    }
+    template <typename T>
+    const T* target() const noexcept { return const_cast<basic_any_of*>(this)->template target<T>(); }
+
+    void swap(basic_any_of& oth) noexcept {
+        alignas(void*) std::byte temp[InlineBytes];
+        if (oth) { oth.vtable_->move(temp, oth.storage_); }
+        if (*this) { vtable_->move(oth.storage_, storage_); }
+        if (oth.vtable_) { oth.vtable_->move(storage_, temp); }
+        std::swap(vtable_, oth.vtable_);
+    }
+
+private:
+    alignas(void*) std::byte storage_[InlineBytes];
+    const _Vtable* vtable_{nullptr};
+};
+
+} // namespace acpp
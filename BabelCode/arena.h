@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "function.h"
+
+namespace acpp {
+
+/// Bump allocator for allocations that all die together, e.g. everything built while
+/// handling one request. reset() drops every allocation at once and keeps the chunks for
+/// the next round; nothing is freed individually and no destructors are run.
+class arena {
+public:
+    static constexpr std::size_t default_chunk_bytes = 64 * 1024;
+
+    explicit arena(std::size_t chunk_bytes = default_chunk_bytes) : chunk_bytes_{chunk_bytes} {}
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    ~arena() {
+        assert(live_objects_ == 0 && "acpp::arena: a function outlives its arena");
+    }
+
+    void* allocate(std::size_t bytes, std::size_t align = alignof(std::max_align_t)) {
+        if (chunk_ < chunks_.size()) {
+            const _Chunk& chunk = chunks_[chunk_];
+            std::size_t offset = _Aligned_offset(chunk.data.get(), used_, align);
+            if (offset + bytes <= chunk.size) {
+                used_ = offset + bytes;
+                return chunk.data.get() + offset;
+            }
+        }
+        return allocate_slow(bytes, align);
+    }
+
+    /// Rewinds to the first chunk. Every pointer handed out before becomes invalid.
+    void reset() noexcept {
+        assert(live_objects_ == 0 && "acpp::arena: a function outlives its arena reset");
+        // Oversized chunks were made for one allocation, don't keep them around
+        std::erase_if(chunks_, [this](const _Chunk& chunk) { return chunk.size != chunk_bytes_; });
+        chunk_ = 0;
+        used_ = 0;
+    }
+
+    std::size_t chunk_count() const noexcept { return chunks_.size(); }
+
+    /// The arena that arena_spill allocates from on this thread
+    static arena* current() noexcept { return current_; }
+
+    /// Makes an arena current on this thread for its lifetime; scopes nest
+    class scope {
+    public:
+        explicit scope(arena& a) noexcept : previous_{std::exchange(current_, &a)} {}
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+        ~scope() { current_ = previous_; }
+
+    private:
+        arena* previous_;
+    };
+
+    void _Track(std::ptrdiff_t delta) noexcept { live_objects_ += delta; }
+
+private:
+    struct _Chunk {
+        std::unique_ptr<std::byte[]> data;
+        std::size_t size;
+    };
+
+    // Offset of the first address at or after base + from that is a multiple of align. Chunks
+    // only come 16-byte aligned, so it is the address that has to be aligned, not the offset.
+    static std::size_t _Aligned_offset(const std::byte* base, std::size_t from, std::size_t align) noexcept {
+        auto address = reinterpret_cast<uintptr_t>(base);
+        return ((address + from + align - 1) & ~(align - 1)) - address;
+    }
+
+    void* allocate_slow(std::size_t bytes, std::size_t align) {
+        // Next kept chunk, if any, else a new one
+        while (++chunk_ < chunks_.size()) {
+            if (bytes + align <= chunks_[chunk_].size) { break; }
+        }
+        if (chunk_ >= chunks_.size()) {
+            std::size_t size = bytes + align > chunk_bytes_ ? bytes + align : chunk_bytes_;
+            chunks_.push_back({std::unique_ptr<std::byte[]>(new std::byte[size]), size});
+            chunk_ = chunks_.size() - 1;
+        }
+        std::size_t offset = _Aligned_offset(chunks_[chunk_].data.get(), 0, align);
+        used_ = offset + bytes;
+        return chunks_[chunk_].data.get() + offset;
+    }
+
+    std::size_t chunk_bytes_;
+    std::vector<_Chunk> chunks_;
+    std::size_t chunk_{0};
+    std::size_t used_{0};
+    std::ptrdiff_t live_objects_{0};
+
+    static inline thread_local arena* current_{nullptr};
+};
+
+/// Spill policy for basic_function: callables that don't fit the local buffer go to the
+/// current arena, and destroying them only runs the destructor. Copies made later
+/// allocate from whichever arena is current at that point.
+///
+/// The owning arena is kept in front of every object, in all builds, so the layout doesn't
+/// depend on NDEBUG; its live count is what the arena's debug asserts check.
+struct arena_spill {
+    template <typename T, typename... CtorArgs>
+    static T* create(CtorArgs&&... args) {
+        arena* a = arena::current();
+        if (!a) { throw std::logic_error("acpp::arena_spill: no current arena"); }
+        constexpr std::size_t header = (sizeof(arena*) + alignof(T) - 1) / alignof(T) * alignof(T);
+        auto* bytes = static_cast<std::byte*>(a->allocate(header + sizeof(T), alignof(T) > alignof(arena*) ? alignof(T) : alignof(arena*)));
+        T* obj = new (bytes + header) T(std::forward<CtorArgs>(args)...);
+        *reinterpret_cast<arena**>(bytes + header - sizeof(arena*)) = a;
+        a->_Track(+1);
+        return obj;
+    }
+
+    template <typename T>
+    static void destroy(T* ptr) {
+        ptr->~T();
+        (*reinterpret_cast<arena**>(reinterpret_cast<std::byte*>(ptr) - sizeof(arena*)))->_Track(-1);
+    }
+};
+
+template <typename Signature>
+using arena_function = basic_function<Signature, arena_spill>;
+
+} // namespace acpp
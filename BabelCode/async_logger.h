@@ -0,0 +1,549 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <climits>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "any_of.h"
+
+namespace acpp {
+namespace detail {
+
+// The one operation of a log record closure besides destroy; the record is passed along so
+// the closure can find the strings copied behind it
+struct _Format_record {
+    using signature = void(const self&, const unsigned char* record, std::string& out);
+    static void call(const auto& closure, const unsigned char* record, std::string& out) { closure.format(record, out); }
+};
+
+// Constant-initialized vtable of a closure that stays in the ring, so producers never write to it
+using _Record_ops = _Any_vtable<_Format_record>;
+
+inline uint64_t _Steady_ns() noexcept {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Hot-path timestamp: the TSC where there is one (half the cost of clock_gettime),
+// steady_clock nanoseconds elsewhere
+inline uint64_t _Log_ticks() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return _Steady_ns();
+#endif
+}
+
+// Maps _Log_ticks() to steady_clock nanoseconds on the background thread. calibrate() runs
+// before every drain: it measures the rate over everything since the start, so it keeps
+// getting more precise, and re-anchors the mapping at the current time, so the error of a
+// timestamp is the rate error times the record's age at that drain and never accumulates.
+struct _Tick_converter {
+    uint64_t tick_start{_Log_ticks()};
+    uint64_t ns_start{_Steady_ns()};
+    uint64_t tick_anchor{tick_start};
+    uint64_t ns_anchor{ns_start};
+    double ns_per_tick{1.0};
+
+    void calibrate() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        uint64_t ticks = _Log_ticks();
+        uint64_t ns = _Steady_ns();
+        if (ticks != tick_start) {
+            ns_per_tick = static_cast<double>(ns - ns_start) / static_cast<double>(ticks - tick_start);
+        }
+        tick_anchor = ticks;
+        ns_anchor = ns;
+#endif
+    }
+
+    uint64_t to_ns(uint64_t ticks) const noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        // Records logged before the anchor come out negative
+        auto offset = static_cast<int64_t>(static_cast<double>(static_cast<int64_t>(ticks - tick_anchor)) * ns_per_tick);
+        return ns_anchor + static_cast<uint64_t>(offset);
+#else
+        return ticks;
+#endif
+    }
+};
+
+// Every record starts with this; a null ops marks the padding that skips the ring's wrap point
+struct _Record_header {
+    const _Record_ops* ops;
+    uint32_t size;
+    uint32_t closure_offset;
+    uint64_t timestamp;
+};
+
+inline constexpr std::size_t _Record_align = 16;
+
+constexpr std::size_t _Round_up(std::size_t n, std::size_t align) noexcept { return (n + align - 1) & ~(align - 1); }
+
+// String arguments are copied into the record behind the closure; the closure keeps where
+template <typename T>
+concept _Log_string = std::is_convertible_v<const T&, std::string_view> && !std::is_same_v<std::decay_t<T>, char>;
+
+struct _Str_ref {
+    uint32_t offset;
+    uint32_t length;
+};
+
+template <typename T>
+using _Captured_t = std::conditional_t<_Log_string<T>, _Str_ref, std::decay_t<T>>;
+
+// A null C string would be undefined behaviour in string_view; it is logged as "(null)"
+template <typename T>
+std::string_view _Log_view(const T& arg) noexcept {
+    if constexpr (std::is_null_pointer_v<T>) {
+        return "(null)";
+    } else if constexpr (std::is_pointer_v<T>) {
+        return arg ? std::string_view(arg) : std::string_view("(null)");
+    } else {
+        return std::string_view(arg);
+    }
+}
+
+inline void _Append_arg(std::string& out, const unsigned char* record, _Str_ref str) {
+    out.append(reinterpret_cast<const char*>(record) + str.offset, str.length);
+}
+
+template <typename T>
+void _Append_arg(std::string& out, const unsigned char*, const T& value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        out.append(value ? "true" : "false");
+    } else if constexpr (std::is_same_v<T, char>) {
+        out.push_back(value);
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        char buf[64];
+        auto res = std::to_chars(buf, buf + sizeof(buf), value);
+        out.append(buf, res.ptr);
+    } else if constexpr (std::is_enum_v<T>) {
+        _Append_arg(out, nullptr, static_cast<std::underlying_type_t<T>>(value));
+    } else if constexpr (std::is_pointer_v<T>) {
+        char buf[32] = {'0', 'x'};
+        auto res = std::to_chars(buf + 2, buf + sizeof(buf), reinterpret_cast<uintptr_t>(value), 16);
+        out.append(buf, res.ptr);
+    } else {
+        static_assert(std::is_arithmetic_v<T>, "async_logger: unsupported argument type");
+    }
+}
+
+// Copies the literal text of fmt up to the next "{}" and returns where it stopped
+inline const char* _Append_literal(std::string& out, const char* fmt) {
+    while (*fmt) {
+        if (fmt[0] == '{' && fmt[1] == '}') { return fmt + 2; }
+        if ((fmt[0] == '{' && fmt[1] == '{') || (fmt[0] == '}' && fmt[1] == '}')) { ++fmt; }
+        out.push_back(*fmt++);
+    }
+    return fmt;
+}
+
+// The deferred formatting closure: the format string plus the captured arguments
+template <typename... Captured>
+struct _Log_closure {
+    const char* fmt;
+    std::tuple<Captured...> args;
+
+    void format(const unsigned char* record, std::string& out) const {
+        const char* next = fmt;
+        std::apply([&](const auto&... captured) {
+            ((next = _Append_literal(out, next), _Append_arg(out, record, captured)), ...);
+        }, args);
+        _Append_literal(out, next);
+    }
+
+    static constexpr const _Record_ops& ops = _Any_pinned_model<_Log_closure, _Format_record>::vtable;
+};
+
+// Single-producer single-consumer ring of variable-sized records that never wrap
+class _Byte_ring {
+public:
+    explicit _Byte_ring(std::size_t capacity)
+        : capacity_{capacity}, mask_{capacity - 1},
+          buf_{static_cast<unsigned char*>(::operator new(capacity, std::align_val_t{_Record_align}))} {
+        // Fault the pages in now rather than on the producer's hot path
+        std::memset(buf_, 0, capacity_);
+    }
+
+    ~_Byte_ring() { ::operator delete(buf_, std::align_val_t{_Record_align}); }
+
+    std::size_t capacity() const noexcept { return capacity_; }
+
+    // Producer side. bytes is a multiple of _Record_align and at most capacity / 2: such a
+    // record always fits once the ring is empty, either before the end or, after skipping
+    // the end, because the skipped part is then shorter than the record.
+    unsigned char* try_reserve(std::size_t bytes) noexcept {
+        std::size_t index = tail_local_ & mask_;
+        std::size_t contiguous = capacity_ - index;
+        std::size_t needed = bytes <= contiguous ? bytes : contiguous + bytes;
+        if (tail_local_ + needed - head_cache_ > capacity_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail_local_ + needed - head_cache_ > capacity_) { return nullptr; }
+        }
+        if (bytes > contiguous) {
+            auto* pad = reinterpret_cast<_Record_header*>(buf_ + index);
+            pad->ops = nullptr;
+            pad->size = static_cast<uint32_t>(contiguous);
+            tail_local_ += contiguous;
+            index = 0;
+        }
+        tail_local_ += bytes;
+        return buf_ + index;
+    }
+
+    void commit() noexcept { tail_.store(tail_local_, std::memory_order_release); }
+
+    uint64_t committed_tail() const noexcept { return tail_local_; }
+
+    // Consumer side: runs on_record for every record published up to limit
+    template <typename OnRecord>
+    std::size_t consume(uint64_t limit, OnRecord&& on_record) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        uint64_t tail = std::min(limit, tail_.load(std::memory_order_acquire));
+        std::size_t count = 0;
+        while (head < tail) {
+            auto* header = reinterpret_cast<_Record_header*>(buf_ + (head & mask_));
+            if (header->ops) {
+                on_record(*header);
+                ++count;
+            }
+            head += header->size;
+        }
+        head_.store(head, std::memory_order_release);
+        return count;
+    }
+
+private:
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    unsigned char* const buf_;
+
+    alignas(64) std::atomic<uint64_t> tail_{0};
+    uint64_t tail_local_{0};
+    uint64_t head_cache_{0};
+
+    alignas(64) std::atomic<uint64_t> head_{0};
+};
+
+// Heap copy of a record that didn't fit the ring, with the ring position it must follow
+struct _Spilled_record {
+    struct _Deleter {
+        void operator()(unsigned char* p) const noexcept { ::operator delete(p, std::align_val_t{_Record_align}); }
+    };
+    std::unique_ptr<unsigned char, _Deleter> bytes;
+    uint64_t after_ring_pos;
+};
+
+struct _Thread_ring {
+    explicit _Thread_ring(std::size_t capacity) : ring{capacity} {}
+
+    _Byte_ring ring;
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> spilling{false};
+    std::mutex spill_mutex;
+    std::vector<_Spilled_record> spilled;
+};
+
+} // namespace detail
+
+/// Logger that defers formatting to a background thread.
+/// log() captures the arguments into a closure written inline into the calling thread's SPSC
+/// byte ring, next to a monotonic timestamp (TSC on x86, printed as steady_clock time); string arguments are copied into the record.
+/// The background thread formats the records and writes them to the file with batched writev.
+/// The format string uses "{}" placeholders and must outlive the logger (e.g. a literal).
+class async_logger {
+public:
+    enum class overflow_policy {
+        drop,   // count and discard the record
+        block,  // spin until the background thread makes room
+        spill   // move the record to a heap list, ordering is kept
+    };
+
+    // Records larger than ring_bytes / 2 can't be placed in the ring: they are spilled under
+    // overflow_policy::spill and rejected with std::length_error under the other policies
+    struct options {
+        std::size_t ring_bytes = 1 << 20;
+        overflow_policy overflow = overflow_policy::drop;
+        std::chrono::microseconds flush_interval{1000};
+    };
+
+    explicit async_logger(const char* path) : async_logger(path, options{}) {}
+
+    async_logger(const char* path, options opts)
+        : opts_{opts}, id_{_Next_id().fetch_add(1) + 1} {
+        if (opts_.ring_bytes < 256 || (opts_.ring_bytes & (opts_.ring_bytes - 1)) != 0) {
+            throw std::invalid_argument("async_logger: ring_bytes must be a power of two >= 256");
+        }
+        fd_ = ::open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd_ < 0) { throw std::system_error(errno, std::generic_category(), "async_logger: open"); }
+        worker_ = std::thread([this] { run(); });
+    }
+
+    async_logger(const async_logger&) = delete;
+    async_logger& operator=(const async_logger&) = delete;
+
+    ~async_logger() {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        wake_cv_.notify_one();
+        worker_.join();
+        ::close(fd_);
+    }
+
+    template <typename... Args>
+    void log(const char* fmt, Args&&... args) {
+        using _Closure = detail::_Log_closure<detail::_Captured_t<Args>...>;
+        static_assert(alignof(_Closure) <= detail::_Record_align);
+        constexpr std::size_t closure_offset = detail::_Round_up(sizeof(detail::_Record_header), alignof(_Closure));
+        constexpr std::size_t strings_offset = closure_offset + sizeof(_Closure);
+        const std::size_t bytes = detail::_Round_up(strings_offset + (std::size_t{0} + ... + _String_bytes(args)),
+                                                    detail::_Record_align);
+        const uint64_t now = detail::_Log_ticks();
+
+        detail::_Thread_ring& tr = thread_ring();
+        const bool fits = bytes <= tr.ring.capacity() / 2;
+        if (!fits && opts_.overflow != overflow_policy::spill) [[unlikely]] {
+            throw std::length_error("async_logger: record larger than ring_bytes / 2");
+        }
+        unsigned char* record = nullptr;
+        if (!tr.spilling.load(std::memory_order_relaxed) && fits) {
+            record = tr.ring.try_reserve(bytes);
+            if (!record && opts_.overflow == overflow_policy::block) {
+                while (!(record = tr.ring.try_reserve(bytes))) { std::this_thread::yield(); }
+            }
+        }
+        const bool spill = !record && opts_.overflow == overflow_policy::spill;
+        if (!record && !spill) {
+            tr.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        detail::_Spilled_record spilled;
+        if (spill) {
+            record = static_cast<unsigned char*>(::operator new(bytes, std::align_val_t{detail::_Record_align}));
+            spilled.bytes.reset(record);
+        }
+
+        auto* header = reinterpret_cast<detail::_Record_header*>(record);
+        header->ops = &_Closure::ops;
+        header->size = static_cast<uint32_t>(bytes);
+        header->closure_offset = closure_offset;
+        header->timestamp = now;
+        [[maybe_unused]] uint32_t cursor = strings_offset; // unused without arguments
+        new (record + closure_offset) _Closure{fmt, {_Capture(std::forward<Args>(args), record, cursor)...}};
+
+        if (spill) {
+            std::lock_guard lock(tr.spill_mutex);
+            spilled.after_ring_pos = tr.ring.committed_tail();
+            tr.spilled.push_back(std::move(spilled));
+            tr.spilling.store(true, std::memory_order_relaxed);
+        } else {
+            tr.ring.commit();
+        }
+    }
+
+    /// Blocks until everything logged before the call is written
+    void flush() {
+        std::unique_lock lock(mutex_);
+        uint64_t target = ++flush_requested_;
+        wake_cv_.notify_one();
+        flushed_cv_.wait(lock, [&] { return flush_done_ >= target; });
+    }
+
+    uint64_t dropped() const {
+        std::lock_guard lock(mutex_);
+        uint64_t total = 0;
+        for (const auto& tr : rings_) { total += tr->dropped.load(std::memory_order_relaxed); }
+        return total;
+    }
+
+private:
+    static std::atomic<uint64_t>& _Next_id() {
+        static std::atomic<uint64_t> next{0};
+        return next;
+    }
+
+    template <typename T>
+    static std::size_t _String_bytes(const T& arg) noexcept {
+        if constexpr (detail::_Log_string<T>) {
+            return detail::_Log_view(arg).size();
+        } else {
+            return 0;
+        }
+    }
+
+    template <typename T>
+    static detail::_Captured_t<T> _Capture(T&& arg, unsigned char* record, uint32_t& cursor) {
+        if constexpr (detail::_Log_string<T>) {
+            std::string_view str = detail::_Log_view(arg);
+            std::memcpy(record + cursor, str.data(), str.size());
+            detail::_Str_ref ref{cursor, static_cast<uint32_t>(str.size())};
+            cursor += ref.length;
+            return ref;
+        } else {
+            return std::forward<T>(arg);
+        }
+    }
+
+    // One ring per (thread, logger); the last one used is cached in a thread_local
+    detail::_Thread_ring& thread_ring() {
+        struct _Cache {
+            uint64_t logger_id{0};
+            detail::_Thread_ring* ring{nullptr};
+        };
+        thread_local _Cache cache;
+        if (cache.logger_id == id_) [[likely]] { return *cache.ring; }
+
+        thread_local std::vector<_Cache> known;
+        for (const _Cache& entry : known) {
+            if (entry.logger_id == id_) {
+                cache = entry;
+                return *cache.ring;
+            }
+        }
+        auto tr = std::make_unique<detail::_Thread_ring>(opts_.ring_bytes);
+        cache = {id_, tr.get()};
+        known.push_back(cache);
+        std::lock_guard lock(mutex_);
+        rings_.push_back(std::move(tr));
+        return *cache.ring;
+    }
+
+    void format_record(const detail::_Record_header& header) {
+        if (used_lines_ == lines_.size()) { lines_.emplace_back(); }
+        std::string& line = lines_[used_lines_++];
+        line.clear();
+        const uint64_t ns = clock_.to_ns(header.timestamp);
+        char buf[32];
+        auto res = std::to_chars(buf, buf + sizeof(buf), ns / 1'000'000'000);
+        line.append(buf, res.ptr).push_back('.');
+        res = std::to_chars(buf, buf + sizeof(buf), ns % 1'000'000'000 + 1'000'000'000);
+        line.append(buf + 1, res.ptr).push_back(' ');
+        const auto* record = reinterpret_cast<const unsigned char*>(&header);
+        void* closure = const_cast<unsigned char*>(record) + header.closure_offset;
+        std::get<0>(header.ops->operations)(closure, record, line);
+        header.ops->destroy(closure);
+        line.push_back('\n');
+        if (used_lines_ == max_iov_) { write_lines(); }
+    }
+
+    void write_lines() {
+        iov_.resize(used_lines_);
+        for (std::size_t i = 0; i < used_lines_; ++i) { iov_[i] = {lines_[i].data(), lines_[i].size()}; }
+        iovec* iov = iov_.data();
+        int count = static_cast<int>(used_lines_);
+        while (count > 0) {
+            ssize_t written = ::writev(fd_, iov, count);
+            if (written < 0) {
+                if (errno == EINTR) { continue; }
+                break;
+            }
+            // Skip what went out, partial writes resume mid-line
+            while (count > 0 && static_cast<std::size_t>(written) >= iov->iov_len) {
+                written -= static_cast<ssize_t>(iov->iov_len);
+                ++iov;
+                --count;
+            }
+            if (count > 0) {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+                iov->iov_len -= static_cast<std::size_t>(written);
+            }
+        }
+        used_lines_ = 0;
+    }
+
+    void drain_ring(detail::_Thread_ring& tr) {
+        auto on_record = [this](const detail::_Record_header& header) { format_record(header); };
+        if (tr.spilling.load(std::memory_order_relaxed)) {
+            std::vector<detail::_Spilled_record> spilled;
+            {
+                std::lock_guard lock(tr.spill_mutex);
+                spilled.swap(tr.spilled);
+                tr.spilling.store(false, std::memory_order_relaxed);
+            }
+            // Records the thread put in the ring before spilling go first
+            for (auto& rec : spilled) {
+                tr.ring.consume(rec.after_ring_pos, on_record);
+                format_record(*reinterpret_cast<detail::_Record_header*>(rec.bytes.get()));
+            }
+        }
+        tr.ring.consume(UINT64_MAX, on_record);
+    }
+
+    void run() {
+        std::vector<detail::_Thread_ring*> rings;
+        std::unique_lock lock(mutex_);
+        while (true) {
+            wake_cv_.wait_for(lock, opts_.flush_interval, [this] { return stopping_ || flush_requested_ > flush_done_; });
+            clock_.calibrate();
+            bool stop = stopping_;
+            uint64_t flush_target = flush_requested_;
+            rings.clear();
+            for (const auto& tr : rings_) { rings.push_back(tr.get()); }
+            lock.unlock();
+
+            for (detail::_Thread_ring* tr : rings) { drain_ring(*tr); }
+            if (used_lines_) { write_lines(); }
+
+            lock.lock();
+            if (flush_target > flush_done_) {
+                flush_done_ = flush_target;
+                flushed_cv_.notify_all();
+            }
+            if (stop) { return; }
+        }
+    }
+
+private:
+    static constexpr std::size_t max_iov_ = IOV_MAX < 256 ? IOV_MAX : 256;
+
+    options opts_;
+    const uint64_t id_;
+    int fd_{-1};
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable flushed_cv_;
+    std::vector<std::unique_ptr<detail::_Thread_ring>> rings_;
+    uint64_t flush_requested_{0};
+    uint64_t flush_done_{0};
+    bool stopping_{false};
+
+    // Background thread only
+    detail::_Tick_converter clock_;
+    std::vector<std::string> lines_;
+    std::size_t used_lines_{0};
+    std::vector<iovec> iov_;
+    std::thread worker_;
+};
+
+} // namespace acpp
@@ -0,0 +1,299 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "function.h"
+#include "thread.h"
+
+#ifdef ACPP_TRACE
+#include "trace.h"
+#endif
+#ifdef ACPP_TASK_LATENCY
+#include "latency_histogram.h"
+#endif
+
+namespace acpp {
+namespace detail {
+
+inline uint64_t _Batch_clock_ns() noexcept {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// One batch worth of slots, reused round robin. Requests, responses and completions are
+// three contiguous arrays indexed by slot; completions keep small callables inline.
+//
+// reserved counts slot claims. A claim below the capacity owns that slot; the claim that
+// takes the last slot seals the batch, and so does a timed flush by adding the capacity in
+// one step. From then on every claim lands past the end, until the batch becomes current
+// again and reserved is reset to 0. The reset comes after the batch is published as
+// current, so a claim or seal that sees a count below the capacity is always on the
+// current batch, even through a stale reference from an earlier round.
+template <typename Req, typename Resp, typename Completion>
+struct _Batch {
+    explicit _Batch(std::size_t capacity)
+        : requests(capacity), responses(capacity), completions(capacity), reserved{capacity} {
+#ifdef ACPP_TRACE
+        trace_ids.resize(capacity);
+        trace_tasks.resize(capacity);
+#endif
+#ifdef ACPP_TASK_LATENCY
+        submitted_ns.resize(capacity);
+#endif
+    }
+
+    std::vector<Req> requests;
+    std::vector<Resp> responses;
+    std::vector<Completion> completions;
+#ifdef ACPP_TRACE
+    std::vector<uint64_t> trace_ids;
+    std::vector<trace::task_info> trace_tasks;
+#endif
+#ifdef ACPP_TASK_LATENCY
+    std::vector<uint64_t> submitted_ns;
+#endif
+    alignas(64) std::atomic<uint64_t> reserved;
+    alignas(64) std::atomic<uint64_t> ready{0}; // slots whose request and completion are written
+    std::atomic<uint64_t> first_ns{0};          // claim time of slot 0, for timed flushes
+    std::atomic<bool> idle{true};               // flushed, free to become current
+};
+
+} // namespace detail
+
+/// Gathers single requests with their completions and hands them to one bulk handler.
+/// submit() claims a slot in the current batch with one atomic add and writes the request
+/// and completion into it; no lock is taken. A batch is flushed when it is full, by the
+/// submitting thread that filled it, or max_delay after its first request, by a timer
+/// thread. The flush calls the handler with the requests and a response per request, then
+/// each completion with its response, on the flushing thread.
+/// The handler must fill every response and must not throw. Req and Resp must be default
+/// constructible; slots are reused, so Req is move-assigned into place.
+template <typename Req, typename Resp>
+class batcher {
+public:
+    using completion = function<void(Resp)>;
+    using bulk_handler = function<void(std::span<Req> requests, std::span<Resp> responses)>;
+
+    struct options {
+        std::size_t max_batch = 64;
+        std::chrono::microseconds max_delay{200}; // 0: flush only when full or on flush()
+        // Batches that can be flushing at once. Above 1 the handler runs concurrently.
+        std::size_t max_concurrent_flushes = 1;
+    };
+
+    struct stats {
+        uint64_t requests;
+        uint64_t batches;
+        uint64_t size_flushes;
+        uint64_t time_flushes;
+        uint64_t manual_flushes; // flush() and the destructor
+    };
+
+    explicit batcher(bulk_handler handler) : batcher(std::move(handler), options{}) {}
+
+    batcher(bulk_handler handler, options opts) : handler_{std::move(handler)}, opts_{opts} {
+        if (opts_.max_batch == 0 || opts_.max_concurrent_flushes == 0) {
+            throw std::invalid_argument("acpp::batcher: max_batch and max_concurrent_flushes must be positive");
+        }
+        // One batch open for submissions plus the ones being flushed
+        for (std::size_t i = 0; i <= opts_.max_concurrent_flushes; ++i) {
+            batches_.push_back(std::make_unique<_Batch>(opts_.max_batch));
+        }
+        batches_[0]->idle.store(false, std::memory_order_relaxed);
+        batches_[0]->reserved.store(0, std::memory_order_relaxed);
+        if (opts_.max_delay.count() > 0) { timer_ = acpp::thread([this] { run_timer(); }); }
+    }
+
+    batcher(const batcher&) = delete;
+    batcher& operator=(const batcher&) = delete;
+
+    /// Flushes what is pending and waits for every flush in progress
+    ~batcher() {
+        if (timer_.joinable()) {
+            {
+                std::lock_guard lock(timer_mutex_);
+                stopping_ = true;
+            }
+            timer_cv_.notify_one();
+            timer_.join();
+        }
+        flush();
+    }
+
+    // The source location is only used by ACPP_TRACE builds, to name the completion's task
+    template <typename Callable>
+        requires std::is_invocable_v<std::decay_t<Callable>&, Resp>
+    void submit(Req request, Callable&& on_done,
+                [[maybe_unused]] std::source_location location = std::source_location::current()) {
+        const uint64_t capacity = opts_.max_batch;
+        while (true) {
+            _Batch& batch = current();
+            uint64_t slot = batch.reserved.fetch_add(1, std::memory_order_acq_rel);
+            if (slot < capacity) [[likely]] {
+                if (slot == 0) { batch.first_ns.store(detail::_Batch_clock_ns(), std::memory_order_relaxed); }
+                batch.requests[slot] = std::move(request);
+                batch.completions[slot] = std::forward<Callable>(on_done);
+#ifdef ACPP_TASK_LATENCY
+                batch.submitted_ns[slot] = detail::_Latency_clock_ns();
+#endif
+#ifdef ACPP_TRACE
+                batch.trace_ids[slot] = 0;
+                if (trace::enabled()) [[unlikely]] {
+                    batch.trace_tasks[slot] = trace::task_of<std::decay_t<Callable>>(location);
+                    batch.trace_ids[slot] = trace::enqueue(batch.trace_tasks[slot]);
+                }
+#endif
+                batch.ready.fetch_add(1, std::memory_order_release);
+                if (slot + 1 == capacity) { seal_and_flush(batch, capacity, size_flushes_); }
+                return;
+            }
+            // Sealed: the sealing thread is about to make the next batch current
+            std::this_thread::yield();
+        }
+    }
+
+    /// Flushes the current batch if it holds anything and waits for all flushes to finish
+    void flush() {
+        _Batch& batch = current();
+        if (batch.reserved.load(std::memory_order_relaxed) != 0) {
+            uint64_t count = batch.reserved.fetch_add(opts_.max_batch, std::memory_order_acq_rel);
+            if (count < opts_.max_batch) { seal_and_flush(batch, count, manual_flushes_); }
+        }
+        // A batch that became current meanwhile was flushed before it reopened; it may stay
+        // open for good, so it is checked on every spin
+        for (const auto& other : batches_) {
+            while (other.get() != &current() && !other->idle.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+#ifdef ACPP_TASK_LATENCY
+    /// Queue delay (submit to the completion starting, which takes in the wait for the batch
+    /// and the bulk handler) and completion run time
+    const task_latency& latency() const noexcept { return latency_; }
+#endif
+
+    stats statistics() const noexcept {
+        return {requests_.load(std::memory_order_relaxed), batches_flushed_.load(std::memory_order_relaxed),
+                size_flushes_.load(std::memory_order_relaxed), time_flushes_.load(std::memory_order_relaxed),
+                manual_flushes_.load(std::memory_order_relaxed)};
+    }
+
+private:
+    using _Batch = detail::_Batch<Req, Resp, completion>;
+
+    _Batch& current() noexcept {
+        return *batches_[current_.load(std::memory_order_acquire) % batches_.size()];
+    }
+
+    // Called by the one thread whose claim sealed the batch, with the number of claimed slots
+    void seal_and_flush(_Batch& batch, uint64_t count, std::atomic<uint64_t>& reason) noexcept {
+        while (batch.ready.load(std::memory_order_acquire) < count) { std::this_thread::yield(); }
+        open_next();
+        if (count) {
+            handler_(std::span<Req>(batch.requests.data(), count), std::span<Resp>(batch.responses.data(), count));
+            for (uint64_t i = 0; i < count; ++i) {
+                complete(batch, i);
+                batch.completions[i] = completion{};
+            }
+            requests_.fetch_add(count, std::memory_order_relaxed);
+            batches_flushed_.fetch_add(1, std::memory_order_relaxed);
+            reason.fetch_add(1, std::memory_order_relaxed);
+        }
+        batch.idle.store(true, std::memory_order_release);
+    }
+
+    void complete(_Batch& batch, uint64_t i) noexcept {
+#ifdef ACPP_TASK_LATENCY
+        uint64_t started_ns = detail::_Latency_clock_ns();
+        latency_.queue_delay.record(started_ns - batch.submitted_ns[i]);
+#endif
+#ifdef ACPP_TRACE
+        if (uint64_t trace_id = batch.trace_ids[i]) [[unlikely]] {
+            trace::start(trace_id, batch.trace_tasks[i]);
+            batch.completions[i](std::move(batch.responses[i]));
+            trace::finish(trace_id, batch.trace_tasks[i]);
+        } else {
+            batch.completions[i](std::move(batch.responses[i]));
+        }
+#else
+        batch.completions[i](std::move(batch.responses[i]));
+#endif
+#ifdef ACPP_TASK_LATENCY
+        latency_.run_time.record(detail::_Latency_clock_ns() - started_ns);
+#endif
+    }
+
+    // Only the sealer of the current batch gets here. Its seal saw the reset of reserved,
+    // the last step of the rotation that opened the batch, so rotations never overlap.
+    void open_next() noexcept {
+        uint64_t next = current_.load(std::memory_order_relaxed) + 1;
+        _Batch& batch = *batches_[next % batches_.size()];
+        // Every other batch still flushing: wait, which throttles the submitters
+        while (!batch.idle.load(std::memory_order_acquire)) { std::this_thread::yield(); }
+        batch.idle.store(false, std::memory_order_relaxed);
+        batch.ready.store(0, std::memory_order_relaxed);
+        batch.first_ns.store(0, std::memory_order_relaxed);
+        // Published before it opens: until the reset, claims through current() still
+        // land past the end and retry, and flush() and the timer can't seal it
+        current_.store(next, std::memory_order_release);
+        batch.reserved.store(0, std::memory_order_release);
+    }
+
+    void run_timer() {
+        const uint64_t max_delay_ns = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(opts_.max_delay).count());
+        const auto period = std::max(opts_.max_delay / 2, std::chrono::microseconds{1});
+        std::unique_lock lock(timer_mutex_);
+        while (!timer_cv_.wait_for(lock, period, [this] { return stopping_; })) {
+            _Batch& batch = current();
+            uint64_t claimed = batch.reserved.load(std::memory_order_relaxed);
+            uint64_t first_ns = batch.first_ns.load(std::memory_order_relaxed);
+            if (claimed == 0 || claimed >= opts_.max_batch || first_ns == 0) { continue; }
+            if (detail::_Batch_clock_ns() - first_ns < max_delay_ns) { continue; }
+            uint64_t count = batch.reserved.fetch_add(opts_.max_batch, std::memory_order_acq_rel);
+            if (count < opts_.max_batch) {
+                lock.unlock();
+                seal_and_flush(batch, count, time_flushes_);
+                lock.lock();
+            }
+        }
+    }
+
+private:
+    bulk_handler handler_;
+    const options opts_;
+    std::vector<std::unique_ptr<_Batch>> batches_;
+    alignas(64) std::atomic<uint64_t> current_{0};
+
+    alignas(64) std::atomic<uint64_t> requests_{0};
+    std::atomic<uint64_t> batches_flushed_{0};
+    std::atomic<uint64_t> size_flushes_{0};
+    std::atomic<uint64_t> time_flushes_{0};
+    std::atomic<uint64_t> manual_flushes_{0};
+#ifdef ACPP_TASK_LATENCY
+    task_latency latency_;
+#endif
+
+    std::mutex timer_mutex_;
+    std::condition_variable timer_cv_;
+    bool stopping_{false};
+    acpp::thread timer_;
+};
+
+} // namespace acpp
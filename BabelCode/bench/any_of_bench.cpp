@@ -0,0 +1,145 @@
+// acpp::any_of against virtual + std::unique_ptr for a collection of 1M shapes of three
+// types, mixed at random: build and destroy it, call a const and a mutating operation over
+// the whole collection, copy it (clone() for the virtual version).
+// g++ -std=c++20 -O2 any_of_bench.cpp -o any_of_bench
+
+#include "../any_of.h"
+#include "perf_counters.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+using acpp::bench::do_not_optimize;
+
+constexpr std::size_t objects = 1'000'000;
+
+// Value types for any_of: circle and square fit the 16-byte buffer, polygon spills
+struct circle {
+    double r;
+    double area() const { return 3.14159 * r * r; }
+    void scale(double k) { r *= k; }
+};
+struct square {
+    double side;
+    double area() const { return side * side; }
+    void scale(double k) { side *= k; }
+};
+struct polygon {
+    double base, height, sides;
+    double area() const { return base * height * sides / 2; }
+    void scale(double k) { base *= k; height *= k; }
+};
+
+struct area {
+    using signature = double(const acpp::self&);
+    static double call(const auto& shape) { return shape.area(); }
+};
+struct scale {
+    using signature = void(acpp::self&, double);
+    static void call(auto& shape, double k) { shape.scale(k); }
+};
+
+using shape = acpp::any_of<acpp::interface<area, scale>>;
+
+// The same shapes as a classic hierarchy
+struct shape_base {
+    virtual ~shape_base() = default;
+    virtual double area() const = 0;
+    virtual void scale(double k) = 0;
+    virtual std::unique_ptr<shape_base> clone() const = 0;
+};
+template <typename T>
+struct virtual_shape final : shape_base {
+    T value;
+    explicit virtual_shape(T v) : value{v} {}
+    double area() const override { return value.area(); }
+    void scale(double k) override { value.scale(k); }
+    std::unique_ptr<shape_base> clone() const override { return std::make_unique<virtual_shape>(*this); }
+};
+
+std::vector<int> kinds() {
+    std::vector<int> out(objects);
+    std::mt19937 rng(42);
+    for (auto& kind : out) { kind = static_cast<int>(rng() % 3); }
+    return out;
+}
+
+} // namespace
+
+int main() {
+    acpp::bench::perf_counters perf;
+    perf.print_header();
+    const std::vector<int> mix = kinds();
+
+    auto build_values = [&] {
+        std::vector<shape> out;
+        out.reserve(objects);
+        for (int kind : mix) {
+            if (kind == 0) { out.emplace_back(circle{1.0}); }
+            else if (kind == 1) { out.emplace_back(square{2.0}); }
+            else { out.emplace_back(polygon{1.0, 2.0, 3.0}); }
+        }
+        return out;
+    };
+    auto build_pointers = [&] {
+        std::vector<std::unique_ptr<shape_base>> out;
+        out.reserve(objects);
+        for (int kind : mix) {
+            if (kind == 0) { out.push_back(std::make_unique<virtual_shape<circle>>(circle{1.0})); }
+            else if (kind == 1) { out.push_back(std::make_unique<virtual_shape<square>>(square{2.0})); }
+            else { out.push_back(std::make_unique<virtual_shape<polygon>>(polygon{1.0, 2.0, 3.0})); }
+        }
+        return out;
+    };
+    perf.run("any_of build+destroy", objects, [&] { do_not_optimize(build_values().data()); });
+    perf.run("virtual build+destroy", objects, [&] { do_not_optimize(build_pointers().data()); });
+
+    std::vector<shape> values = build_values();
+    std::vector<std::unique_ptr<shape_base>> pointers = build_pointers();
+    constexpr int passes = 10;
+    perf.run("any_of area (const op)", objects * passes, [&] {
+        for (int p = 0; p < passes; ++p) {
+            double total = 0;
+            for (const auto& s : values) { total += s.call<area>(); }
+            do_not_optimize(total);
+        }
+    });
+    perf.run("virtual area (const op)", objects * passes, [&] {
+        for (int p = 0; p < passes; ++p) {
+            double total = 0;
+            for (const auto& s : pointers) { total += s->area(); }
+            do_not_optimize(total);
+        }
+    });
+    perf.run("any_of scale (mutating op)", objects * passes, [&] {
+        for (int p = 0; p < passes; ++p) {
+            for (auto& s : values) { s.call<scale>(p & 1 ? 2.0 : 0.5); }
+        }
+    });
+    perf.run("virtual scale (mutating op)", objects * passes, [&] {
+        for (int p = 0; p < passes; ++p) {
+            for (auto& s : pointers) { s->scale(p & 1 ? 2.0 : 0.5); }
+        }
+    });
+
+    perf.run("any_of copy+destroy", objects, [&] {
+        std::vector<shape> copy = values;
+        do_not_optimize(copy.data());
+    });
+    perf.run("virtual copy+destroy", objects, [&] {
+        std::vector<std::unique_ptr<shape_base>> copy;
+        copy.reserve(objects);
+        for (const auto& s : pointers) { copy.push_back(s->clone()); }
+        do_not_optimize(copy.data());
+    });
+
+    // One polygon in three spills; every virtual shape is its own allocation
+    std::printf("\nbytes per object: any_of %zu in the vector + %zu per spilled polygon, "
+                "virtual %zu in the vector + %zu-%zu on the heap\n",
+                sizeof(shape), sizeof(polygon), sizeof(std::unique_ptr<shape_base>),
+                sizeof(virtual_shape<circle>), sizeof(virtual_shape<polygon>));
+    return 0;
+}
@@ -0,0 +1,97 @@
+// Throughput of acpp::batcher against one backend call per request. The backend is a local
+// stand-in for a storage service: each call costs a fixed round trip plus a little per key,
+// both as busy waits. Producers submit single-key lookups with a completion each.
+// g++ -std=c++20 -O2 -pthread batcher_bench.cpp -o batcher_bench
+
+#include "../batcher.h"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int producers = 4;
+constexpr int lookups_per_producer = 50'000;
+constexpr auto round_trip = std::chrono::nanoseconds(2000);
+constexpr auto per_key = std::chrono::nanoseconds(20);
+
+void busy_wait(std::chrono::nanoseconds duration) {
+    auto until = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < until) {}
+}
+
+// Bulk lookup: value of key k is 3k
+void backend_lookup(std::span<const uint64_t> keys, std::span<uint64_t> values) {
+    busy_wait(round_trip + per_key * keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) { values[i] = keys[i] * 3; }
+}
+
+struct counters {
+    alignas(64) std::atomic<uint64_t> done{0};
+    std::atomic<uint64_t> errors{0};
+};
+
+template <typename Submit>
+double run(Submit&& submit) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < producers; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < lookups_per_producer; ++i) { submit(static_cast<uint64_t>(t) << 32 | i); }
+        });
+    }
+    for (auto& thread : threads) { thread.join(); }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return producers * lookups_per_producer / elapsed.count();
+}
+
+} // namespace
+
+int main() {
+    const uint64_t total = uint64_t{producers} * lookups_per_producer;
+    std::printf("%d producers, %llu lookups, backend %lld ns per call + %lld ns per key\n", producers,
+                static_cast<unsigned long long>(total), static_cast<long long>(round_trip.count()),
+                static_cast<long long>(per_key.count()));
+    std::printf("%-22s %14s %10s %12s\n", "mode", "lookups/s", "speedup", "mean batch");
+
+    counters direct;
+    double baseline = run([&](uint64_t key) {
+        uint64_t value = 0;
+        backend_lookup({&key, 1}, {&value, 1});
+        acpp::function<void(uint64_t)> on_done([&direct, key](uint64_t v) {
+            if (v != key * 3) { direct.errors.fetch_add(1, std::memory_order_relaxed); }
+            direct.done.fetch_add(1, std::memory_order_relaxed);
+        });
+        on_done(value);
+    });
+    std::printf("%-22s %14.0f %9.2fx %12s\n", "one call per request", baseline, 1.0, "-");
+
+    for (std::size_t max_batch : {1, 8, 32, 128, 512}) {
+        counters batched;
+        acpp::batcher<uint64_t, uint64_t>::options opts;
+        opts.max_batch = max_batch;
+        opts.max_delay = std::chrono::microseconds(100);
+        acpp::batcher<uint64_t, uint64_t>::stats stats{};
+        double throughput;
+        {
+            acpp::batcher<uint64_t, uint64_t> batcher(
+                [](std::span<uint64_t> keys, std::span<uint64_t> values) { backend_lookup(keys, values); }, opts);
+            throughput = run([&](uint64_t key) {
+                batcher.submit(key, [&batched, key](uint64_t v) {
+                    if (v != key * 3) { batched.errors.fetch_add(1, std::memory_order_relaxed); }
+                    batched.done.fetch_add(1, std::memory_order_relaxed);
+                });
+            });
+            batcher.flush();
+            stats = batcher.statistics();
+        }
+        char mode[32];
+        std::snprintf(mode, sizeof(mode), "batcher max_batch=%zu", max_batch);
+        std::printf("%-22s %14.0f %9.2fx %12.1f%s\n", mode, throughput, throughput / baseline,
+                    static_cast<double>(stats.requests) / static_cast<double>(stats.batches),
+                    batched.done == total && batched.errors == 0 ? "" : "  WRONG RESULTS");
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+// Stress check for acpp::batcher's batch rotation: producers submit while other threads call
+// flush() in a loop and a 1 us timer seals batches too, so size, manual and timed seals race
+// for the same batches. Every completion must run exactly once with its own response, and a
+// watchdog fails the run if progress stops, which is how an overlapping rotation shows up.
+// g++ -std=c++20 -O2 -pthread batcher_stress_check.cpp -o batcher_stress_check
+// ./batcher_stress_check    exit 0 when every configuration passes
+
+#include "../batcher.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int producers = 3;
+constexpr int flushers = 2;
+constexpr int requests_per_producer = 20'000;
+constexpr auto stall_limit = std::chrono::seconds(10);
+
+std::atomic<uint64_t> progress{0};
+std::atomic<bool> finished{false};
+
+// Aborts the run when no completion has run for stall_limit
+void watchdog() {
+    uint64_t last = progress.load();
+    auto last_change = std::chrono::steady_clock::now();
+    while (!finished.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        uint64_t now_seen = progress.load();
+        if (now_seen != last) {
+            last = now_seen;
+            last_change = std::chrono::steady_clock::now();
+        } else if (std::chrono::steady_clock::now() - last_change > stall_limit) {
+            std::printf("stalled: no completion for %lld s\n", static_cast<long long>(stall_limit.count()));
+            std::fflush(stdout);
+            std::_Exit(1);
+        }
+    }
+}
+
+bool run(std::size_t max_batch, std::size_t max_concurrent_flushes) {
+    const std::size_t total = std::size_t{producers} * requests_per_producer;
+    auto calls = std::make_unique<std::atomic<uint32_t>[]>(total);
+    std::atomic<uint64_t> wrong{0};
+    acpp::batcher<uint64_t, uint64_t>::stats stats{};
+    {
+        acpp::batcher<uint64_t, uint64_t>::options opts;
+        opts.max_batch = max_batch;
+        opts.max_delay = std::chrono::microseconds(1);
+        opts.max_concurrent_flushes = max_concurrent_flushes;
+        acpp::batcher<uint64_t, uint64_t> batcher(
+            [](std::span<uint64_t> keys, std::span<uint64_t> values) {
+                for (std::size_t i = 0; i < keys.size(); ++i) { values[i] = keys[i] + 1; }
+            },
+            opts);
+
+        std::atomic<int> producing{producers};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < producers; ++t) {
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < requests_per_producer; ++i) {
+                    uint64_t key = static_cast<uint64_t>(t) * requests_per_producer + i;
+                    batcher.submit(key, [&, key](uint64_t value) {
+                        if (value != key + 1) { wrong.fetch_add(1, std::memory_order_relaxed); }
+                        calls[key].fetch_add(1, std::memory_order_relaxed);
+                        progress.fetch_add(1, std::memory_order_relaxed);
+                    });
+                }
+                producing.fetch_sub(1);
+            });
+        }
+        for (int t = 0; t < flushers; ++t) {
+            threads.emplace_back([&] {
+                while (producing.load() > 0) { batcher.flush(); }
+            });
+        }
+        for (auto& thread : threads) { thread.join(); }
+        batcher.flush();
+        stats = batcher.statistics();
+    }
+
+    std::size_t missing = 0, repeated = 0;
+    for (std::size_t i = 0; i < total; ++i) {
+        uint32_t n = calls[i].load();
+        missing += n == 0;
+        repeated += n > 1;
+    }
+    bool ok = missing == 0 && repeated == 0 && wrong == 0 && stats.requests == total;
+    std::printf("max_batch %3zu, %zu concurrent: %6llu batches (%llu size, %llu timed, %llu manual)  %s\n", max_batch,
+                max_concurrent_flushes, static_cast<unsigned long long>(stats.batches),
+                static_cast<unsigned long long>(stats.size_flushes), static_cast<unsigned long long>(stats.time_flushes),
+                static_cast<unsigned long long>(stats.manual_flushes), ok ? "ok" : "FAILED");
+    if (!ok) { std::printf("  %zu missing, %zu repeated, %llu wrong responses\n", missing, repeated,
+                           static_cast<unsigned long long>(wrong.load())); }
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    std::thread guard(watchdog);
+    bool ok = true;
+    for (std::size_t max_batch : {1, 2, 3, 16, 64}) {
+        for (std::size_t concurrent : {1, 2, 4}) { ok &= run(max_batch, concurrent); }
+    }
+    finished.store(true);
+    guard.join();
+    std::printf(ok ? "batcher rotation clean\n" : "batcher rotation FAILED\n");
+    return ok ? 0 : 1;
+}
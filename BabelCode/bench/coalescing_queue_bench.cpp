@@ -0,0 +1,122 @@
+// Event storms through acpp::coalescing_queue against a plain FIFO of functions. Each tick
+// posts a burst of events whose keys follow a Zipf distribution over 1024 keys (a few hot
+// config entries, a long tail), then drains. Reported per event: time, handler runs and
+// heap allocations; the handlers capture 48 bytes, so a queued one spills to the heap.
+// g++ -std=c++20 -O2 coalescing_queue_bench.cpp -o coalescing_queue_bench
+
+#include "../coalescing_queue.h"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::size_t allocations = 0;
+
+} // namespace
+
+void* operator new(std::size_t bytes) {
+    ++allocations;
+    if (void* ptr = std::malloc(bytes ? bytes : 1)) { return ptr; }
+    throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace {
+
+constexpr int keys = 1024;
+constexpr int ticks = 2000;
+constexpr int events_per_tick = 1000;
+
+std::vector<int> zipf_keys(double skew) {
+    std::vector<double> cdf(keys);
+    double sum = 0;
+    for (int k = 0; k < keys; ++k) { cdf[k] = sum += 1.0 / std::pow(k + 1, skew); }
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> uniform(0, sum);
+    std::vector<int> out(static_cast<std::size_t>(ticks) * events_per_tick);
+    for (auto& key : out) { key = static_cast<int>(std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin()); }
+    return out;
+}
+
+struct config_delta {
+    std::array<long, 5> fields;
+    long* applied;
+    void operator()() { *applied += fields[0]; }
+};
+
+// The FIFO every post used to go through
+class fifo_queue {
+public:
+    template <typename Callable>
+    void post(Callable&& callable) {
+        std::lock_guard lock(mutex_);
+        pending_.emplace_back(std::forward<Callable>(callable));
+    }
+    std::size_t drain() {
+        std::vector<acpp::function<void()>> batch;
+        {
+            std::lock_guard lock(mutex_);
+            batch.swap(pending_);
+        }
+        for (auto& callable : batch) { callable(); }
+        return batch.size();
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<acpp::function<void()>> pending_;
+};
+
+template <typename Post, typename Drain>
+void run(const char* name, const std::vector<int>& events, Post&& post, Drain&& drain) {
+    std::size_t runs = 0;
+    std::size_t before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < ticks; ++t) {
+        for (int e = 0; e < events_per_tick; ++e) { post(events[static_cast<std::size_t>(t) * events_per_tick + e]); }
+        runs += drain();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    double n = static_cast<double>(events.size());
+    std::printf("%-30s %10.1f %12.3f %12.3f\n", name, elapsed.count() / n, static_cast<double>(runs) / n,
+                static_cast<double>(allocations - before) / n);
+}
+
+} // namespace
+
+int main() {
+    for (double skew : {0.8, 1.2}) {
+        const std::vector<int> events = zipf_keys(skew);
+        std::printf("\nZipf skew %.1f over %d keys, %d events per tick\n", skew, keys, events_per_tick);
+        std::printf("%-30s %10s %12s %12s\n", "queue", "ns/event", "runs/event", "allocs/event");
+        long applied = 0;
+
+        fifo_queue fifo;
+        run("fifo", events, [&](int key) { fifo.post(config_delta{{key, 1, 2, 3, 4}, &applied}); },
+            [&] { return fifo.drain(); });
+
+        acpp::coalescing_queue<int> replacing;
+        run("coalescing, replace", events,
+            [&](int key) { replacing.post(key, config_delta{{key, 1, 2, 3, 4}, &applied}); },
+            [&] { return replacing.drain(); });
+
+        acpp::coalescing_queue<int> merging;
+        run("coalescing, merge deltas", events,
+            [&](int key) {
+                merging.post(key, config_delta{{key, 1, 2, 3, 4}, &applied},
+                             [](config_delta& pending, config_delta&& incoming) { pending.fields[0] += incoming.fields[0]; });
+            },
+            [&] { return merging.drain(); });
+        if (applied == 42) { std::puts(""); }
+    }
+    return 0;
+}
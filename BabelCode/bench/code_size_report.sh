@@ -0,0 +1,54 @@
+#!/usr/bin/env bash
+# Text-section bytes per acpp::function instantiation.
+# Compiles a synthetic translation unit with N distinct callables stored in acpp::function,
+# for trivially copyable, non-trivial and spilled (40-byte, trivially copyable) captures,
+# with heap_spill and with acpp::shared_ops<>, and reports (text(N) - text(0)) / N.
+#   ./code_size_report.sh [N]           CXX and CXXFLAGS are honoured (default g++ -O2)
+set -euo pipefail
+
+n=${1:-200}
+cxx=${CXX:-g++}
+cxxflags=${CXXFLAGS:--O2}
+here=$(cd "$(dirname "$0")" && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+# $1 = count, $2 = trivial|nontrivial|spilled, $3 = spill policy
+generate() {
+    {
+        echo '#include "function.h"'
+        echo '#include <memory>'
+        echo 'struct counted { std::shared_ptr<int> p; };'
+        echo 'struct wide { long v[5]; };'
+        echo "using fn = acpp::basic_function<int(int), $3>;"
+        for ((i = 0; i < $1; ++i)); do
+            case $2 in
+                trivial) echo "fn make_$i(int k) { return [k](int x) { return x * $i + k; }; }" ;;
+                nontrivial) echo "fn make_$i(counted c) { return [c](int x) { return x * $i + *c.p; }; }" ;;
+                spilled) echo "fn make_$i(wide w) { return [w](int x) { return x * $i + int(w.v[4]); }; }" ;;
+            esac
+        done
+        # Copy and move every erased type so their operations are emitted too
+        echo 'void exercise(fn& f) { fn g(f); f = std::move(g); }'
+    } > "$work/tu.cpp"
+}
+
+# $1 = count, $2 = kind, $3 = spill policy; prints text bytes
+text_bytes() {
+    generate "$1" "$2" "$3"
+    # shellcheck disable=SC2086
+    "$cxx" -std=c++20 $cxxflags -I"$here/.." -c "$work/tu.cpp" -o "$work/tu.o"
+    size -A "$work/tu.o" | awk '$1 ~ /^\.text/ { sum += $2 } END { print sum + 0 }'
+}
+
+printf '%-12s %-8s %10s %10s %12s\n' kind sharing "text(0)" "text($n)" "bytes/inst"
+for kind in trivial nontrivial spilled; do
+    for share in off on; do
+        spill=acpp::heap_spill
+        [[ $share == on ]] && spill='acpp::shared_ops<>'
+        base=$(text_bytes 0 "$kind" "$spill")
+        full=$(text_bytes "$n" "$kind" "$spill")
+        printf '%-12s %-8s %10d %10d %12.1f\n' "$kind" "$share" "$base" "$full" \
+            "$(awk -v a="$base" -v b="$full" -v n="$n" 'BEGIN { print (b - a) / n }')"
+    done
+done
@@ -0,0 +1,214 @@
+// Type erasure strategies behind the same function API (see BabelLibrary/00_C++/00_PatternsAndConcepts.md):
+//   virtual   - CallableConcept/CallableModel with virtual invoke/clone, model on the heap
+//   table     - one constexpr static table {invoke, copy, move, destroy} + 16 byte local buffer
+//   acpp      - acpp::function: _Operations table + separate invoker_ pointer + 16 byte local buffer
+//   std       - std::function
+// Call, copy and move at monomorphic, 4-way and 64-way polymorphic call sites, plus sizeof.
+// g++ -std=c++20 -O2 erasure_strategies_bench.cpp -o erasure_strategies_bench
+
+#include "../function.h"
+#include "perf_counters.h"
+
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using acpp::bench::do_not_optimize;
+
+// Erasure through inheritance, as in the notes
+template <typename Signature>
+class virtual_function;
+
+template <typename R, typename... Args>
+class virtual_function<R(Args...)> {
+    struct _Concept {
+        virtual ~_Concept() = default;
+        virtual R invoke(Args... args) = 0;
+        virtual _Concept* clone() const = 0;
+    };
+    template <typename F>
+    struct _Model final : _Concept {
+        explicit _Model(F f) : f_{std::move(f)} {}
+        R invoke(Args... args) override { return f_(std::forward<Args>(args)...); }
+        _Concept* clone() const override { return new _Model(f_); }
+        F f_;
+    };
+
+public:
+    virtual_function() = default;
+    template <typename F>
+        requires(!std::is_same_v<std::remove_cvref_t<F>, virtual_function>)
+    virtual_function(F&& f) : callable_{new _Model<std::decay_t<F>>(std::forward<F>(f))} {}
+    virtual_function(const virtual_function& oth) : callable_{oth.callable_ ? oth.callable_->clone() : nullptr} {}
+    virtual_function(virtual_function&&) noexcept = default;
+    virtual_function& operator=(virtual_function oth) noexcept { callable_ = std::move(oth.callable_); return *this; }
+
+    R operator()(Args... args) {
+        if (!callable_) { throw std::runtime_error("bad function call"); }
+        return callable_->invoke(std::forward<Args>(args)...);
+    }
+
+private:
+    std::unique_ptr<_Concept> callable_;
+};
+
+// Erasure through one static function table per type, the callable in a local buffer
+template <typename Signature>
+class table_function;
+
+template <typename R, typename... Args>
+class table_function<R(Args...)> {
+    struct alignas(8) _Storage {
+        unsigned char bytes[16];
+    };
+    struct _Table {
+        R (*invoke)(_Storage&, Args...);
+        void (*copy)(_Storage& dst, const _Storage& src);
+        void (*move)(_Storage& dst, _Storage& src) noexcept;
+        void (*destroy)(_Storage&) noexcept;
+    };
+    template <typename F>
+    static constexpr bool _Local = sizeof(F) <= sizeof(_Storage) && alignof(_Storage) % alignof(F) == 0 &&
+                                   std::is_nothrow_move_constructible_v<F>;
+    template <typename F>
+    static F& _Get(_Storage& s) noexcept {
+        if constexpr (_Local<F>) { return *std::launder(reinterpret_cast<F*>(s.bytes)); }
+        else { return **std::launder(reinterpret_cast<F**>(s.bytes)); }
+    }
+    template <typename F>
+    static constexpr _Table _Table_for{
+        [](_Storage& s, Args... args) -> R { return _Get<F>(s)(std::forward<Args>(args)...); },
+        [](_Storage& dst, const _Storage& src) {
+            F& from = _Get<F>(const_cast<_Storage&>(src));
+            if constexpr (_Local<F>) { new (dst.bytes) F(from); }
+            else { *reinterpret_cast<F**>(dst.bytes) = new F(from); }
+        },
+        [](_Storage& dst, _Storage& src) noexcept {
+            if constexpr (_Local<F>) {
+                new (dst.bytes) F(std::move(_Get<F>(src)));
+                _Get<F>(src).~F();
+            } else {
+                dst = src;
+            }
+        },
+        [](_Storage& s) noexcept {
+            if constexpr (_Local<F>) { _Get<F>(s).~F(); }
+            else { delete &_Get<F>(s); }
+        },
+    };
+
+public:
+    table_function() = default;
+    template <typename F>
+        requires(!std::is_same_v<std::remove_cvref_t<F>, table_function>)
+    table_function(F&& f) {
+        using _Fn = std::decay_t<F>;
+        if constexpr (_Local<_Fn>) { new (storage_.bytes) _Fn(std::forward<F>(f)); }
+        else { *reinterpret_cast<_Fn**>(storage_.bytes) = new _Fn(std::forward<F>(f)); }
+        table_ = &_Table_for<_Fn>;
+    }
+    table_function(const table_function& oth) : table_{oth.table_} {
+        if (table_) { table_->copy(storage_, oth.storage_); }
+    }
+    table_function(table_function&& oth) noexcept : table_{std::exchange(oth.table_, nullptr)} {
+        if (table_) { table_->move(storage_, oth.storage_); }
+    }
+    table_function& operator=(table_function oth) noexcept {
+        this->~table_function();
+        return *new (this) table_function(std::move(oth));
+    }
+    ~table_function() {
+        if (table_) { table_->destroy(storage_); }
+    }
+
+    R operator()(Args... args) {
+        if (!table_) { throw std::runtime_error("bad function call"); }
+        return table_->invoke(storage_, std::forward<Args>(args)...);
+    }
+
+private:
+    _Storage storage_;
+    const _Table* table_{nullptr};
+};
+
+constexpr std::size_t slots = 4096;
+constexpr std::size_t call_rounds = 256;
+constexpr std::size_t copy_rounds = 64;
+
+// Every I is a distinct closure type
+template <int I>
+auto make_callable(long& acc) {
+    return [&acc](int x) { acc += x * (I + 1); };
+}
+
+template <typename Fn, int... Is>
+std::vector<Fn> make_functions(long& acc, std::size_t kinds, std::integer_sequence<int, Is...>) {
+    using maker = Fn (*)(long&);
+    maker makers[] = {+[](long& a) -> Fn { return make_callable<Is>(a); }...};
+    std::vector<Fn> fns;
+    fns.reserve(slots);
+    std::mt19937 rng(1234);
+    for (std::size_t i = 0; i < slots; ++i) { fns.push_back(makers[kinds == 1 ? 0 : rng() % kinds](acc)); }
+    return fns;
+}
+
+template <typename Fn>
+void run(acpp::bench::perf_counters& perf, const char* strategy, long& acc) {
+    for (std::size_t kinds : {std::size_t{1}, std::size_t{4}, std::size_t{64}}) {
+        auto fns = make_functions<Fn>(acc, kinds, std::make_integer_sequence<int, 64>{});
+        std::string site = kinds == 1 ? "mono" : std::to_string(kinds) + "-way";
+
+        perf.run((std::string(strategy) + " call " + site).c_str(), slots * call_rounds, [&] {
+            for (std::size_t r = 0; r < call_rounds; ++r) {
+                for (auto& fn : fns) { fn(static_cast<int>(r)); }
+            }
+        });
+
+        std::vector<Fn> copies;
+        copies.reserve(slots);
+        perf.run((std::string(strategy) + " copy " + site).c_str(), slots * copy_rounds, [&] {
+            for (std::size_t r = 0; r < copy_rounds; ++r) {
+                copies.clear();
+                for (const auto& fn : fns) { copies.push_back(fn); }
+                do_not_optimize(copies.data());
+            }
+        });
+
+        // Moves go back and forth between two vectors, each step is one move and one destroy
+        std::vector<Fn> moved;
+        moved.reserve(slots);
+        perf.run((std::string(strategy) + " move " + site).c_str(), slots * copy_rounds, [&] {
+            for (std::size_t r = 0; r < copy_rounds; ++r) {
+                auto& from = r % 2 ? moved : copies;
+                auto& to = r % 2 ? copies : moved;
+                to.clear();
+                for (auto& fn : from) { to.push_back(std::move(fn)); }
+                from.clear();
+                do_not_optimize(to.data());
+            }
+        });
+    }
+}
+
+} // namespace
+
+int main() {
+    std::printf("sizeof: virtual %zu  table %zu  acpp %zu  std %zu\n",
+                sizeof(virtual_function<void(int)>), sizeof(table_function<void(int)>),
+                sizeof(acpp::function<void(int)>), sizeof(std::function<void(int)>));
+
+    acpp::bench::perf_counters perf;
+    perf.print_header();
+    long acc = 0;
+    run<virtual_function<void(int)>>(perf, "virtual", acc);
+    run<table_function<void(int)>>(perf, "table", acc);
+    run<acpp::function<void(int)>>(perf, "acpp", acc);
+    run<std::function<void(int)>>(perf, "std", acc);
+    do_not_optimize(acc);
+    return 0;
+}
@@ -0,0 +1,133 @@
+// acpp::fiber costs: context switches between two fibers on one worker, against a handoff
+// between two OS threads, then 100k fibers alive at once, each yielding a few times and
+// meeting at a fiber_condition_variable barrier. Reported: time per yield (a yield switches
+// to the worker and on to the next fiber), spawn and completion times, peak RSS.
+// g++ -std=c++20 -O2 -pthread fiber_bench.cpp ../fiber.cpp -o fiber_bench
+// Add -DACPP_FIBER_UCONTEXT to measure the ucontext fallback.
+
+#include "../fiber.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr int ping_pong_rounds = 1'000'000;
+constexpr int fiber_count = 100'000;
+constexpr int yields_per_fiber = 10;
+
+double elapsed_ns(clock_type::time_point start) {
+    return std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+}
+
+long peak_rss_mib() {
+    rusage usage{};
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024;
+}
+
+void fiber_ping_pong() {
+    acpp::fiber_scheduler scheduler({.workers = 1});
+    auto player = [] {
+        for (int i = 0; i < ping_pong_rounds; ++i) { acpp::this_fiber::yield(); }
+    };
+    auto start = clock_type::now();
+    acpp::fiber a = scheduler.spawn(player);
+    acpp::fiber b = scheduler.spawn(player);
+    a.join();
+    b.join();
+    double ns = elapsed_ns(start) / (2.0 * ping_pong_rounds);
+    std::printf("  fiber yield, 2 fibers on 1 worker      %8.1f ns  (%.1f ns per context switch)\n", ns, ns / 2);
+}
+
+// The same handoff between two threads, blocking on a futex each turn
+void thread_ping_pong() {
+    std::atomic<uint32_t> turn{0};
+    auto player = [&](uint32_t me) {
+        for (int i = 0; i < ping_pong_rounds / 10; ++i) {
+            uint32_t seen;
+            while ((seen = turn.load(std::memory_order_acquire)) != me) { turn.wait(seen, std::memory_order_acquire); }
+            turn.store(1 - me, std::memory_order_release);
+            turn.notify_one();
+        }
+    };
+    auto start = clock_type::now();
+    std::thread other(player, 1);
+    player(0);
+    other.join();
+    std::printf("  OS thread handoff, futex wait/notify   %8.1f ns\n", elapsed_ns(start) / (2.0 * ping_pong_rounds / 10));
+}
+
+// Each stack with a guard page is two memory mappings; stay clear of the kernel's limit
+bool guard_pages_fit(std::size_t stacks) {
+    std::ifstream limit_file("/proc/sys/vm/max_map_count");
+    std::size_t limit = 0;
+    if (!(limit_file >> limit)) { return true; }
+    return 2 * stacks + 10'000 < limit;
+}
+
+void many_fibers() {
+    acpp::fiber_scheduler::options opts;
+    opts.stack_bytes = 16 * 1024;
+    opts.guard_pages = guard_pages_fit(fiber_count);
+    acpp::fiber_scheduler scheduler(opts);
+    std::printf("  %d fibers, %zu KiB stacks, guard pages %s, %u workers\n", fiber_count, opts.stack_bytes / 1024,
+                opts.guard_pages ? "on" : "off (above vm.max_map_count)", std::max(1u, std::thread::hardware_concurrency()));
+
+    acpp::fiber_mutex mutex;
+    acpp::fiber_condition_variable all_arrived;
+    int arrived = 0;
+    std::atomic<clock_type::rep> yields_done_at{0};
+
+    std::vector<acpp::fiber> fibers;
+    fibers.reserve(fiber_count);
+    auto start = clock_type::now();
+    for (int i = 0; i < fiber_count; ++i) {
+        fibers.push_back(scheduler.spawn([&] {
+            for (int k = 0; k < yields_per_fiber; ++k) { acpp::this_fiber::yield(); }
+            std::unique_lock lock(mutex);
+            if (++arrived == fiber_count) {
+                yields_done_at.store(clock_type::now().time_since_epoch().count(), std::memory_order_relaxed);
+                all_arrived.notify_all();
+            } else {
+                all_arrived.wait(lock, [&] { return arrived == fiber_count; });
+            }
+        }));
+    }
+    double spawn_ns = elapsed_ns(start);
+    for (auto& fiber : fibers) { fiber.join(); }
+    double total_ns = elapsed_ns(start);
+    double barrier_ns = total_ns - std::chrono::duration<double, std::nano>(
+        clock_type::time_point(clock_type::duration(yields_done_at.load())) - start).count();
+
+    std::printf("  spawn                                  %8.1f ns per fiber (%.1f ms)\n", spawn_ns / fiber_count, spawn_ns / 1e6);
+    std::printf("  whole run / %d yields per fiber        %8.1f ns per yield (upper bound)\n", yields_per_fiber,
+                total_ns / (static_cast<double>(fiber_count) * yields_per_fiber));
+    std::printf("  barrier release and join               %8.1f ms\n", barrier_ns / 1e6);
+    std::printf("  total                                  %8.1f ms, peak RSS %ld MiB\n", total_ns / 1e6, peak_rss_mib());
+}
+
+} // namespace
+
+int main() {
+#ifdef ACPP_FIBER_UCONTEXT
+    std::printf("context switch: ucontext\n");
+#else
+    std::printf("context switch: hand-written assembly\n");
+#endif
+    std::printf("switch cost\n");
+    fiber_ping_pong();
+    thread_ping_pong();
+    std::printf("concurrent fibers\n");
+    many_fibers();
+}
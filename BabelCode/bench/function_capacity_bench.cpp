@@ -0,0 +1,74 @@
+// Inline-capacity recording on a synthetic workload: callables of 8 to 64 bytes stored into
+// two signatures from several threads, then the per-signature report. Also the cost of one
+// recorded store against an unrecorded one.
+// g++ -std=c++20 -O2 -pthread -DACPP_FUNCTION_CAPACITY function_capacity_bench.cpp -o function_capacity_bench
+// ACPP_FUNCTION_CAPACITY_REPORT=capacity.txt ./function_capacity_bench   also writes the report at exit
+
+#include "../function.h"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+template <std::size_t Words>
+auto capture(long& acc) {
+    std::array<long, Words> pad{};
+    pad[0] = static_cast<long>(Words);
+    return [&acc, pad](int x) { acc += x + pad[0]; };
+}
+
+// Mostly small captures with a tail of bigger ones, as in a typical service
+void workload(std::size_t stores, unsigned seed) {
+    long acc = 0;
+    std::mt19937 rng(seed);
+    std::discrete_distribution<int> pick({50, 25, 12, 8, 5});
+    for (std::size_t i = 0; i < stores; ++i) {
+        acpp::function<void(int)> fn;
+        switch (pick(rng)) {
+        case 0: fn = [&acc](int x) { acc += x; }; break;
+        case 1: fn = capture<1>(acc); break;
+        case 2: fn = capture<2>(acc); break;
+        case 3: fn = capture<3>(acc); break;
+        default: fn = capture<7>(acc); break;
+        }
+        fn(1);
+        acpp::function<bool()> check([&acc, i] { return acc > static_cast<long>(i); });
+        acc += check();
+    }
+    if (acc == 42) { std::puts(""); }
+}
+
+// Own signature so these stores show up apart from the workload's
+double ns_per_store(std::size_t stores) {
+    long acc = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < stores; ++i) {
+        acpp::function<void(long)> fn([&acc](long x) { acc += x; });
+        fn(1);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    if (acc == 42) { std::puts(""); }
+    return elapsed.count() / static_cast<double>(stores);
+}
+
+} // namespace
+
+int main() {
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < 4; ++t) { threads.emplace_back(workload, 200'000, t); }
+    for (auto& thread : threads) { thread.join(); }
+
+    std::printf("inline store + call + destroy: %.2f ns\n\n", ns_per_store(10'000'000));
+#ifdef ACPP_FUNCTION_CAPACITY
+    acpp::print_function_capacity(stdout, 0.95);
+    std::puts("");
+    acpp::print_function_capacity(stdout, 0.80);
+#else
+    std::puts("built without -DACPP_FUNCTION_CAPACITY, no report");
+#endif
+}
@@ -0,0 +1,100 @@
+// Per-operation hardware counters for acpp::function: invocation through invoker_ at
+// monomorphic and polymorphic call sites, inline vs heap callables, construction,
+// destruction and copy. Falls back to ns/op when perf_event_open is not permitted.
+// g++ -std=c++20 -O2 function_perf_bench.cpp -o function_perf_bench
+
+#include "../function.h"
+#include "perf_counters.h"
+
+#include <array>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using acpp::bench::do_not_optimize;
+
+constexpr std::size_t slots = 4096;
+constexpr std::size_t rounds = 256;
+
+// Every I is a distinct closure type, hence a distinct invoker_
+template <int I>
+auto small_callable(long& acc) {
+    return [&acc](int x) { acc += x * (I + 1); };
+}
+
+template <int I>
+auto large_callable(long& acc) {
+    std::array<long, 4> pad{I, I + 1, I + 2, I + 3};
+    return [&acc, pad](int x) { acc += x * (I + 1) + pad[x & 3]; };
+}
+
+template <bool Large, int... Is>
+std::vector<acpp::function<void(int)>> make_functions(long& acc, std::size_t kinds, std::integer_sequence<int, Is...>) {
+    using maker = acpp::function<void(int)> (*)(long&);
+    maker makers[] = {+[](long& a) -> acpp::function<void(int)> {
+        if constexpr (Large) { return large_callable<Is>(a); } else { return small_callable<Is>(a); }
+    }...};
+    std::vector<acpp::function<void(int)>> fns;
+    std::mt19937 rng(1234);
+    for (std::size_t i = 0; i < slots; ++i) { fns.push_back(makers[kinds == 1 ? 0 : rng() % kinds](acc)); }
+    return fns;
+}
+
+void invoke_all(std::vector<acpp::function<void(int)>>& fns) {
+    for (std::size_t r = 0; r < rounds; ++r) {
+        for (auto& fn : fns) { fn(static_cast<int>(r)); }
+    }
+}
+
+} // namespace
+
+int main() {
+    acpp::bench::perf_counters perf;
+    perf.print_header();
+    long acc = 0;
+    const uint64_t calls = slots * rounds;
+
+    for (bool large : {false, true}) {
+        for (std::size_t kinds : {std::size_t{1}, std::size_t{4}, std::size_t{16}}) {
+            auto fns = large ? make_functions<true>(acc, kinds, std::make_integer_sequence<int, 16>{})
+                             : make_functions<false>(acc, kinds, std::make_integer_sequence<int, 16>{});
+            std::string name = std::string("invoke ") + (large ? "heap " : "inline ") +
+                               (kinds == 1 ? "monomorphic" : std::to_string(kinds) + "-way");
+            perf.run(name.c_str(), calls, [&] { invoke_all(fns); });
+        }
+    }
+
+    auto small = small_callable<0>(acc);
+    auto large = large_callable<0>(acc);
+    constexpr uint64_t lifetimes = 1'000'000;
+    perf.run("construct+destroy inline", lifetimes, [&] {
+        for (uint64_t i = 0; i < lifetimes; ++i) {
+            acpp::function<void(int)> fn(small);
+            do_not_optimize(fn);
+        }
+    });
+    perf.run("construct+destroy heap", lifetimes, [&] {
+        for (uint64_t i = 0; i < lifetimes; ++i) {
+            acpp::function<void(int)> fn(large);
+            do_not_optimize(fn);
+        }
+    });
+    acpp::function<void(int)> small_fn(small);
+    acpp::function<void(int)> large_fn(large);
+    perf.run("copy+destroy inline", lifetimes, [&] {
+        for (uint64_t i = 0; i < lifetimes; ++i) {
+            acpp::function<void(int)> fn(small_fn);
+            do_not_optimize(fn);
+        }
+    });
+    perf.run("copy+destroy heap", lifetimes, [&] {
+        for (uint64_t i = 0; i < lifetimes; ++i) {
+            acpp::function<void(int)> fn(large_fn);
+            do_not_optimize(fn);
+        }
+    });
+    do_not_optimize(acc);
+    return 0;
+}
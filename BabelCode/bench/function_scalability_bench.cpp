@@ -0,0 +1,154 @@
+// Throughput of acpp::function construction, copy, invocation and destruction on 1..N threads,
+// inline and heap callables, to surface shared writes that only show under parallelism
+// (vtable initialization, the global allocator behind heap spills). Each thread works on its
+// own objects; perfect scaling is N times the single-thread throughput. Scenarios below
+// ACPP_SCALING_FLAG (default 0.8) of that are flagged.
+// g++ -std=c++20 -O2 -pthread function_scalability_bench.cpp -o function_scalability_bench
+// ./function_scalability_bench [max_threads]   default: hardware threads, at least 4
+
+#include "../arena.h"
+#include "../function.h"
+#include "perf_counters.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef ACPP_SCALING_FLAG
+#define ACPP_SCALING_FLAG 0.8
+#endif
+
+namespace {
+
+using acpp::bench::do_not_optimize;
+
+constexpr uint64_t ops_per_thread = 2'000'000;
+
+auto small_callable(long& acc) {
+    return [&acc](int x) { acc += x; };
+}
+
+auto large_callable(long& acc) {
+    std::array<long, 4> pad{1, 2, 3, 4};
+    return [&acc, pad](int x) { acc += x + pad[x & 3]; };
+}
+
+template <typename Callable>
+void construct_destroy(Callable callable) {
+    for (uint64_t i = 0; i < ops_per_thread; ++i) {
+        acpp::function<void(int)> fn(callable);
+        do_not_optimize(fn);
+    }
+}
+
+template <typename Callable>
+void arena_construct_destroy(Callable callable) {
+    acpp::arena arena;
+    acpp::arena::scope scope(arena);
+    for (uint64_t i = 0; i < ops_per_thread; ++i) {
+        {
+            acpp::arena_function<void(int)> fn(callable);
+            do_not_optimize(fn);
+        }
+        if ((i & 1023) == 1023) { arena.reset(); }
+    }
+}
+
+template <typename Callable>
+void copy_destroy(Callable callable) {
+    acpp::function<void(int)> source(callable);
+    for (uint64_t i = 0; i < ops_per_thread; ++i) {
+        acpp::function<void(int)> fn(source);
+        do_not_optimize(fn);
+    }
+}
+
+template <typename Callable>
+void invoke(Callable callable) {
+    acpp::function<void(int)> fn(callable);
+    for (uint64_t i = 0; i < ops_per_thread; ++i) { fn(static_cast<int>(i)); }
+}
+
+struct scenario {
+    const char* name;
+    void (*body)();
+};
+
+// Every thread gets its own accumulator, on its own cache line
+struct alignas(64) padded_acc {
+    long value;
+};
+thread_local padded_acc acc;
+
+// Millions of operations per second over all threads
+double run(const scenario& s, unsigned threads) {
+    std::atomic<unsigned> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) { std::this_thread::yield(); }
+            s.body();
+            do_not_optimize(acc.value);
+        });
+    }
+    while (ready.load() != threads) { std::this_thread::yield(); }
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& worker : workers) { worker.join(); }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(ops_per_thread) * threads / elapsed.count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    unsigned max_threads = argc > 1 ? static_cast<unsigned>(std::max(1, std::atoi(argv[1]))) : std::max(4u, hardware);
+
+    // Powers of two, then max_threads itself
+    std::vector<unsigned> counts;
+    for (unsigned threads = 1; threads < max_threads; threads *= 2) { counts.push_back(threads); }
+    counts.push_back(max_threads);
+
+    const scenario scenarios[] = {
+        {"construct+destroy inline", [] { construct_destroy(small_callable(acc.value)); }},
+        {"construct+destroy heap", [] { construct_destroy(large_callable(acc.value)); }},
+        {"construct+destroy arena", [] { arena_construct_destroy(large_callable(acc.value)); }},
+        {"copy+destroy inline", [] { copy_destroy(small_callable(acc.value)); }},
+        {"copy+destroy heap", [] { copy_destroy(large_callable(acc.value)); }},
+        {"invoke inline", [] { invoke(small_callable(acc.value)); }},
+        {"invoke heap", [] { invoke(large_callable(acc.value)); }},
+    };
+
+    std::printf("%u hardware threads; efficiency = Mops(N) / (N * Mops(1)), flagged below %.2f\n", hardware,
+                ACPP_SCALING_FLAG);
+    std::printf("%-26s %8s %10s %11s\n", "scenario", "threads", "Mops/s", "efficiency");
+    int flagged = 0;
+    for (const auto& s : scenarios) {
+        double single = 0.0;
+        for (unsigned threads : counts) {
+            double mops = run(s, threads);
+            if (threads == 1) { single = mops; }
+            double efficiency = mops / (threads * single);
+            // Past the hardware threads nothing can scale, those rows are informational
+            const char* note = "";
+            if (threads > hardware) {
+                note = "  (oversubscribed)";
+            } else if (efficiency < ACPP_SCALING_FLAG) {
+                note = "  SUBLINEAR";
+                ++flagged;
+            }
+            std::printf("%-26s %8u %10.1f %11.2f%s\n", s.name, threads, mops, efficiency, note);
+        }
+    }
+    std::printf("%d scenario(s) scale worse than linearly\n", flagged);
+    return flagged ? 1 : 0;
+}
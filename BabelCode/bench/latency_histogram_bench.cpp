@@ -0,0 +1,68 @@
+// Cost per latency_histogram::record (target: under 10ns), from one thread and from several
+// threads into the same histogram (thread CPU time), plus the cost of merging a snapshot.
+// g++ -std=c++20 -O2 -pthread latency_histogram_bench.cpp -o latency_histogram_bench
+
+#include "../latency_histogram.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <time.h>
+
+namespace {
+
+constexpr std::size_t samples_per_thread = 10'000'000;
+
+// Pre-generated, latency-like values so the loop measures record() and not the generator
+std::vector<uint64_t> make_values() {
+    std::mt19937_64 rng(42);
+    std::lognormal_distribution<double> dist(7.0, 1.2);
+    std::vector<uint64_t> values(1 << 16);
+    for (auto& v : values) { v = static_cast<uint64_t>(dist(rng)); }
+    return values;
+}
+
+// Thread CPU time, so threads sharing a core don't inflate each other's figures
+double thread_cpu_ns() {
+    timespec ts;
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) * 1e9 + static_cast<double>(ts.tv_nsec);
+}
+
+double record_ns(acpp::latency_histogram& histogram, const std::vector<uint64_t>& values) {
+    double start = thread_cpu_ns();
+    for (std::size_t i = 0; i < samples_per_thread; ++i) { histogram.record(values[i & (values.size() - 1)]); }
+    return (thread_cpu_ns() - start) / static_cast<double>(samples_per_thread);
+}
+
+} // namespace
+
+int main() {
+    const auto values = make_values();
+    acpp::latency_histogram histogram;
+    record_ns(histogram, values);
+    std::printf("1 thread   %6.2f ns/record\n", record_ns(histogram, values));
+
+    for (unsigned threads : {2u, 4u}) {
+        std::vector<double> ns(threads);
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] { ns[t] = record_ns(histogram, values); });
+        }
+        for (auto& worker : workers) { worker.join(); }
+        double mean = 0;
+        for (double n : ns) { mean += n / threads; }
+        std::printf("%u threads  %6.2f ns/record (per thread)\n", threads, mean);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    acpp::latency_snapshot snapshot = histogram.snapshot();
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    std::printf("snapshot   %6.1f us for %llu samples\n", us, static_cast<unsigned long long>(snapshot.count()));
+    std::string text = snapshot.to_text("synthetic_ns");
+    std::printf("%s", text.substr(0, text.find('\n') + 1).c_str());
+    return 0;
+}
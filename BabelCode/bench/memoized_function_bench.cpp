@@ -0,0 +1,83 @@
+// Throughput of acpp::memoized_function against calling the callable directly, on 1..64
+// threads, for uniform and Zipf-skewed keys.
+// g++ -std=c++20 -O2 -pthread memoized_function_bench.cpp -o memoized_function_bench
+
+#include "../memoized_function.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t key_space = 100'000;
+// Split across the threads so every row does the same total work
+constexpr std::size_t total_calls = 1'000'000;
+
+// Stand-in for a pricing lookup: ~1us of arithmetic
+double expensive(uint32_t key) {
+    double x = key;
+    for (int i = 0; i < 100; ++i) { x = std::sqrt(x * 1.0001 + i); }
+    return x;
+}
+
+std::vector<uint32_t> make_keys(double zipf_s, uint32_t seed, std::size_t count) {
+    std::mt19937 rng(seed);
+    std::vector<uint32_t> keys(count);
+    if (zipf_s == 0.0) {
+        std::uniform_int_distribution<uint32_t> uniform(0, key_space - 1);
+        for (auto& key : keys) { key = uniform(rng); }
+        return keys;
+    }
+    std::vector<double> cdf(key_space);
+    double sum = 0;
+    for (uint32_t k = 0; k < key_space; ++k) { cdf[k] = (sum += 1.0 / std::pow(k + 1.0, zipf_s)); }
+    std::uniform_real_distribution<double> uniform(0, sum);
+    for (auto& key : keys) {
+        key = static_cast<uint32_t>(std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin());
+    }
+    return keys;
+}
+
+template <typename Fn>
+double mcalls_per_sec(unsigned threads, const std::vector<std::vector<uint32_t>>& keys, Fn&& fn) {
+    std::vector<std::thread> workers;
+    std::atomic<double> sink{0};
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            double local = 0;
+            const std::size_t count = total_calls / threads;
+            for (std::size_t i = 0; i < count; ++i) { local += fn(keys[t][i]); }
+            sink.fetch_add(local);
+        });
+    }
+    for (auto& worker : workers) { worker.join(); }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(total_calls) / secs / 1e6;
+}
+
+} // namespace
+
+int main() {
+    for (double zipf_s : {0.0, 0.99, 1.2}) {
+        std::vector<std::vector<uint32_t>> keys;
+        // Distinct streams per thread; a thread uses the first total_calls / threads keys
+        for (unsigned t = 0; t < 64; ++t) { keys.push_back(make_keys(zipf_s, t + 1, total_calls)); }
+        std::printf("keys: %s\n", zipf_s == 0.0 ? "uniform" : (zipf_s < 1.0 ? "zipf s=0.99" : "zipf s=1.2"));
+        for (unsigned threads : {1u, 4u, 16u, 64u}) {
+            double direct = mcalls_per_sec(threads, keys, [](uint32_t key) { return expensive(key); });
+            acpp::memoized_function<double(uint32_t)> memo(&expensive, 16'384, 64);
+            double memoized = mcalls_per_sec(threads, keys, [&](uint32_t key) { return memo(key); });
+            auto s = memo.statistics();
+            std::printf("  %2u threads: direct %6.2f  memoized %6.2f Mcalls/s  hit %5.1f%%  evictions %llu\n",
+                        threads, direct, memoized, 100.0 * static_cast<double>(s.hits) / static_cast<double>(s.hits + s.misses),
+                        static_cast<unsigned long long>(s.evictions));
+        }
+    }
+    return 0;
+}
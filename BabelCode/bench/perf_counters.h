@@ -0,0 +1,146 @@
+#pragma once
+
+// Hardware counter harness for the benchmarks: opens a set of perf_event_open counters for
+// the calling thread (user space only) and reports them per operation next to ns/op.
+// Counters the kernel or the CPU refuse are skipped; with none available it is timing only.
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace acpp::bench {
+
+struct counter_spec {
+    const char* name;
+    uint32_t type;
+    uint64_t config;
+};
+
+inline constexpr uint64_t _Cache_event(uint64_t cache, uint64_t op, uint64_t result) {
+    return cache | (op << 8) | (result << 16);
+}
+
+/// Default set. Indirect-branch mispredictions have no generic event, so they're only
+/// counted when ACPP_PERF_INDIRECT_MISS gives the raw event code of the CPU
+/// (e.g. 0x80c5 = BR_MISP_RETIRED.INDIRECT on recent Intel cores).
+inline std::vector<counter_spec> default_counters() {
+    std::vector<counter_spec> specs{
+        {"instr", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {"br-miss", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {"L1d-miss", PERF_TYPE_HW_CACHE,
+         _Cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+        {"L1i-miss", PERF_TYPE_HW_CACHE,
+         _Cache_event(PERF_COUNT_HW_CACHE_L1I, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    };
+    if (const char* raw = std::getenv("ACPP_PERF_INDIRECT_MISS")) {
+        specs.push_back({"ind-miss", PERF_TYPE_RAW, std::strtoull(raw, nullptr, 0)});
+    }
+    return specs;
+}
+
+class perf_counters {
+public:
+    explicit perf_counters(std::vector<counter_spec> specs = default_counters()) {
+        for (const counter_spec& spec : specs) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = spec.type;
+            attr.config = spec.config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int fd = static_cast<int>(::syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fd < 0) {
+                skipped_.push_back(std::string(spec.name) + " (" + std::strerror(errno) + ")");
+                continue;
+            }
+            counters_.push_back({spec.name, fd, 0});
+        }
+    }
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    ~perf_counters() {
+        for (auto& counter : counters_) { ::close(counter.fd); }
+    }
+
+    bool timing_only() const noexcept { return counters_.empty(); }
+    const std::vector<std::string>& skipped() const noexcept { return skipped_; }
+
+    void start() {
+        for (auto& counter : counters_) {
+            ::ioctl(counter.fd, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        start_ = std::chrono::steady_clock::now();
+    }
+
+    void stop() {
+        elapsed_ns_ = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_).count();
+        for (auto& counter : counters_) {
+            ::ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t values[3] = {};
+            if (::read(counter.fd, values, sizeof(values)) != sizeof(values)) {
+                counter.value = 0;
+                continue;
+            }
+            // Scale up when the kernel multiplexed the counter
+            counter.value = values[2] ? static_cast<double>(values[0]) * static_cast<double>(values[1]) / static_cast<double>(values[2])
+                                      : 0.0;
+        }
+    }
+
+    /// Runs body once for warm up, then measured, and prints one line of per-op figures
+    template <typename Body>
+    void run(const char* scenario, uint64_t ops, Body&& body) {
+        body();
+        start();
+        body();
+        stop();
+        std::printf("%-34s %8.2f ns/op", scenario, elapsed_ns_ / static_cast<double>(ops));
+        for (const auto& counter : counters_) {
+            std::printf("  %s %7.3f", counter.name, counter.value / static_cast<double>(ops));
+        }
+        std::printf("\n");
+    }
+
+    void print_header() const {
+        if (timing_only()) {
+            std::printf("perf_event_open unavailable, timing only\n");
+        }
+        for (const auto& skipped : skipped_) { std::printf("skipped counter: %s\n", skipped.c_str()); }
+    }
+
+private:
+    struct _Counter {
+        const char* name;
+        int fd;
+        double value;
+    };
+
+    std::vector<_Counter> counters_;
+    std::vector<std::string> skipped_;
+    std::chrono::steady_clock::time_point start_;
+    double elapsed_ns_{0};
+};
+
+/// Keeps the optimizer from discarding a value
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace acpp::bench
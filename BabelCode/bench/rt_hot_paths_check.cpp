@@ -0,0 +1,116 @@
+// Certifies that the library's hot paths neither allocate nor lock once set up: each one runs
+// inside an acpp::rt_scope with the abort policy, so any violation fails the run. Meant for CI.
+// g++ -std=c++20 -O2 -DACPP_RT_CHECK rt_hot_paths_check.cpp ../rt_scope.cpp -o rt_hot_paths_check
+// ./rt_hot_paths_check            exit 0 when every hot path is clean
+// ./rt_hot_paths_check --selftest checks that a heap copy and a lock are detected
+
+#include "../dispatcher.h"
+#include "../function.h"
+#include "../lazy.h"
+#include "../rt_scope.h"
+#include "../signal.h"
+#include "../state_machine.h"
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+namespace {
+
+enum class state { idle, open, count };
+enum class event { open, data, close, count };
+
+struct session {
+    uint64_t bytes = 0;
+};
+
+constexpr auto make_table() {
+    acpp::transition_table<state, event, session> table;
+    table.on(state::idle, event::open, state::open)
+         .on(state::open, event::data, state::open, [](session& s) { s.bytes += 64; })
+         .on(state::open, event::close, state::idle);
+    return table;
+}
+
+constexpr auto table = make_table();
+
+struct message {
+    uint32_t type_id;
+    uint32_t payload;
+};
+
+template <typename Body>
+void certify(const char* name, Body&& body) {
+    {
+        acpp::rt_scope scope(name);
+        body();
+    }
+    std::printf("clean: %s\n", name);
+}
+
+int selftest() {
+    acpp::rt_scope::set_policy(acpp::rt_violation_policy::report);
+    std::string big(64, 'x');
+    acpp::function<std::size_t()> large([big] { return big.size(); });
+    std::mutex mutex;
+    uint64_t before = acpp::rt_scope::violations();
+    {
+        acpp::rt_scope scope("selftest");
+        acpp::function<std::size_t()> copy(large);
+        std::lock_guard lock(mutex);
+    }
+    uint64_t seen = acpp::rt_scope::violations() - before;
+    // At least: the heap copy, the string copy inside it, the lock and the two frees
+    std::printf("selftest: %llu violations reported\n", static_cast<unsigned long long>(seen));
+    return seen >= 3 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "--selftest") == 0) { return selftest(); }
+    acpp::rt_scope::set_policy(acpp::rt_violation_policy::abort);
+
+    // Everything is built outside the scopes; only steady-state work is certified
+    long acc = 0;
+    acpp::function<void(int)> inline_fn([&acc](int x) { acc += x; });
+    certify("function invoke", [&] {
+        for (int i = 0; i < 1000; ++i) { inline_fn(i); }
+    });
+    certify("function move and swap (inline callable)", [&] {
+        acpp::function<void(int)> moved(std::move(inline_fn));
+        moved.swap(inline_fn);
+    });
+
+    session s;
+    acpp::state_machine<state, event, session> machine(table, state::idle, s);
+    certify("state_machine process", [&] {
+        for (int i = 0; i < 1000; ++i) {
+            machine.process(event::open);
+            machine.process(event::data);
+            machine.process(event::close);
+        }
+    });
+
+    acpp::dispatcher<message> dispatcher;
+    for (uint32_t id = 0; id < 8; ++id) {
+        dispatcher.subscribe(id, [&acc](const message& msg) { acc += msg.payload; });
+    }
+    certify("dispatcher dispatch", [&] {
+        for (uint32_t i = 0; i < 1000; ++i) { dispatcher.dispatch(message{i % 8, i}); }
+    });
+
+    acpp::signal<void(int)> signal;
+    auto connection = signal.connect([&acc](int x) { acc += x; });
+    certify("signal emit", [&] {
+        for (int i = 0; i < 1000; ++i) { signal.emit(i); }
+    });
+
+    acpp::lazy<long> value([] { return 42L; });
+    value.get();
+    certify("lazy get after initialization", [&] { acc += value.get(); });
+
+    std::printf("all hot paths clean (%ld)\n", acc);
+    return 0;
+}
@@ -0,0 +1,145 @@
+// Events per second for a small connection protocol: hand-written switch, a
+// std::unordered_map of std::function transitions, and acpp::state_machine with a
+// constexpr table and with a runtime table of capturing lambdas.
+// g++ -std=c++20 -O2 state_machine_bench.cpp -o state_machine_bench
+
+#include "../state_machine.h"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+enum class state { idle, connecting, open, closing, count };
+enum class event { connect, ack, data, close, timeout, count };
+
+struct session {
+    uint64_t bytes = 0;
+    uint64_t retries = 0;
+    uint64_t opened = 0;
+    bool can_retry() const { return retries < (1ull << 62); }
+};
+
+constexpr auto make_table() {
+    acpp::transition_table<state, event, session> table;
+    table.on(state::idle, event::connect, state::connecting)
+         .on(state::connecting, event::ack, state::open, [](session& s) { ++s.opened; })
+         .on_guarded(state::connecting, event::timeout, [](session& s) { return s.can_retry(); },
+                     state::connecting, [](session& s) { ++s.retries; })
+         .on(state::open, event::data, state::open, [](session& s) { s.bytes += 64; })
+         .on(state::open, event::close, state::closing)
+         .on(state::open, event::timeout, state::idle)
+         .on(state::closing, event::ack, state::idle)
+         .on(state::closing, event::timeout, state::idle);
+    return table;
+}
+
+constexpr auto constexpr_table = make_table();
+
+state step_switch(state current, event ev, session& s) {
+    switch (current) {
+        case state::idle:
+            if (ev == event::connect) { return state::connecting; }
+            break;
+        case state::connecting:
+            if (ev == event::ack) { ++s.opened; return state::open; }
+            if (ev == event::timeout && s.can_retry()) { ++s.retries; return state::connecting; }
+            break;
+        case state::open:
+            if (ev == event::data) { s.bytes += 64; return state::open; }
+            if (ev == event::close) { return state::closing; }
+            if (ev == event::timeout) { return state::idle; }
+            break;
+        case state::closing:
+            if (ev == event::ack || ev == event::timeout) { return state::idle; }
+            break;
+        default: break;
+    }
+    return current;
+}
+
+struct map_transition {
+    state target;
+    std::function<bool()> guard;
+    std::function<void()> action;
+};
+
+template <typename Fn>
+double mevents_per_sec(std::size_t count, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return static_cast<double>(count) / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / 1e6;
+}
+
+} // namespace
+
+int main() {
+    constexpr std::size_t stream_size = 1 << 16;
+    constexpr std::size_t rounds = 256;
+    std::vector<event> events(stream_size);
+    std::mt19937 rng(7);
+    // Mostly data, like a real connection
+    std::discrete_distribution<int> pick({1, 2, 10, 1, 1});
+    for (auto& ev : events) { ev = static_cast<event>(pick(rng)); }
+    const std::size_t total = stream_size * rounds;
+
+    session s1;
+    state current = state::idle;
+    double switch_rate = mevents_per_sec(total, [&] {
+        for (std::size_t r = 0; r < rounds; ++r) { for (event ev : events) { current = step_switch(current, ev, s1); } }
+    });
+
+    session s2;
+    std::unordered_map<int, map_transition> map;
+    auto key = [](state st, event ev) { return static_cast<int>(st) * 8 + static_cast<int>(ev); };
+    map[key(state::idle, event::connect)] = {state::connecting, {}, {}};
+    map[key(state::connecting, event::ack)] = {state::open, {}, [&] { ++s2.opened; }};
+    map[key(state::connecting, event::timeout)] = {state::connecting, [&] { return s2.can_retry(); }, [&] { ++s2.retries; }};
+    map[key(state::open, event::data)] = {state::open, {}, [&] { s2.bytes += 64; }};
+    map[key(state::open, event::close)] = {state::closing, {}, {}};
+    map[key(state::open, event::timeout)] = {state::idle, {}, {}};
+    map[key(state::closing, event::ack)] = {state::idle, {}, {}};
+    map[key(state::closing, event::timeout)] = {state::idle, {}, {}};
+    current = state::idle;
+    double map_rate = mevents_per_sec(total, [&] {
+        for (std::size_t r = 0; r < rounds; ++r) {
+            for (event ev : events) {
+                auto it = map.find(key(current, ev));
+                if (it == map.end() || (it->second.guard && !it->second.guard())) { continue; }
+                if (it->second.action) { it->second.action(); }
+                current = it->second.target;
+            }
+        }
+    });
+
+    session s3;
+    acpp::state_machine<state, event, session> fsm(constexpr_table, state::idle, s3);
+    double table_rate = mevents_per_sec(total, [&] {
+        for (std::size_t r = 0; r < rounds; ++r) { for (event ev : events) { fsm.process(ev); } }
+    });
+    fsm.reset(state::idle);
+    double batch_rate = mevents_per_sec(total, [&] {
+        for (std::size_t r = 0; r < rounds; ++r) { fsm.process_batch(events); }
+    });
+
+    // Runtime table with capturing closures (stored inline)
+    session s4;
+    uint64_t data_bytes = 64;
+    acpp::transition_table<state, event, session> runtime_table = make_table();
+    runtime_table.on(state::open, event::data, state::open, [&data_bytes](session& s) { s.bytes += data_bytes; });
+    acpp::state_machine<state, event, session> runtime_fsm(runtime_table, state::idle, s4);
+    double runtime_rate = mevents_per_sec(total, [&] {
+        for (std::size_t r = 0; r < rounds; ++r) { runtime_fsm.process_batch(events); }
+    });
+
+    std::printf("switch                     %8.1f Mevents/s\n", switch_rate);
+    std::printf("unordered_map+std::function %7.1f Mevents/s\n", map_rate);
+    std::printf("state_machine process      %8.1f Mevents/s\n", table_rate);
+    std::printf("state_machine process_batch %7.1f Mevents/s\n", batch_rate);
+    std::printf("runtime table process_batch %7.1f Mevents/s\n", runtime_rate);
+    return (s1.bytes == s2.bytes && s2.bytes == s3.bytes / 2 && s3.bytes / 2 == s4.bytes) ? 0 : 1;
+}
@@ -0,0 +1,49 @@
+// Per-task cost of the ACPP_TRACE hooks on uring_file_io reads: tracing compiled out, compiled
+// in but disabled (one branch per hook), and enabled (three ring events per task). The rings are
+// never flushed here, so once full the enabled run measures the drop path.
+// g++ -std=c++20 -O2 trace_bench.cpp -o trace_bench_off
+// g++ -std=c++20 -O2 -DACPP_TRACE trace_bench.cpp -o trace_bench
+
+#include "../uring_file_io.h"
+
+#include <chrono>
+#include <cstdio>
+
+#include <fcntl.h>
+
+namespace {
+
+double ns_per_task(acpp::uring_file_io& io, int fd, int tasks) {
+    char byte = 0;
+    long sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < tasks; ++i) {
+        io.read(fd, &byte, 1, 0, [&sum](int res) { sum += res; });
+        if (i % 64 == 63) { io.drain(); }
+    }
+    io.drain();
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return sum == tasks ? ns / tasks : -1.0;
+}
+
+} // namespace
+
+int main() {
+    constexpr int tasks = 200'000;
+    int fd = ::open("/dev/zero", O_RDONLY);
+    acpp::uring_file_io io({.queue_depth = 64, .fallback_threads = 1, .force_fallback = false});
+    ns_per_task(io, fd, tasks / 10);
+#ifdef ACPP_TRACE
+    std::printf("tracing disabled  %8.1f ns/task\n", ns_per_task(io, fd, tasks));
+    acpp::trace::enable();
+    std::printf("tracing enabled   %8.1f ns/task\n", ns_per_task(io, fd, tasks));
+    acpp::trace::disable();
+    std::printf("dropped events    %8llu (ring of %d per thread)\n",
+                static_cast<unsigned long long>(acpp::trace::dropped()), ACPP_TRACE_RING_EVENTS);
+    acpp::trace::flush("/tmp/acpp_trace_bench.json");
+#else
+    std::printf("tracing compiled out %8.1f ns/task\n", ns_per_task(io, fd, tasks));
+#endif
+    ::close(fd);
+    return 0;
+}
@@ -0,0 +1,97 @@
+// Local temp-file throughput: blocking pread/pwrite vs acpp::uring_file_io (io_uring and fallback).
+// g++ -std=c++20 -O2 -pthread -I.. uring_file_io_bench.cpp -o uring_file_io_bench
+
+#include "../uring_file_io.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+namespace {
+
+constexpr std::size_t block_size = 4096;
+constexpr std::size_t block_count = 16384;  // 64 MiB
+constexpr unsigned batch = 64;
+
+struct temp_file {
+    char path[64] = "/tmp/acpp_uring_benchXXXXXX";
+    int fd = ::mkstemp(path);
+    ~temp_file() { ::close(fd); ::unlink(path); }
+};
+
+template <typename Fn>
+double seconds(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const char* name, double secs) {
+    double mib = block_count * block_size / (1024.0 * 1024.0);
+    std::printf("%-34s %8.1f MiB/s %8.0f ns/op\n", name, mib / secs, secs * 1e9 / block_count);
+}
+
+void bench_blocking(int fd, unsigned char* buf) {
+    report("blocking pwrite", seconds([&] {
+        for (std::size_t i = 0; i < block_count; ++i) { ::pwrite(fd, buf, block_size, i * block_size); }
+    }));
+    report("blocking pread", seconds([&] {
+        for (std::size_t i = 0; i < block_count; ++i) { ::pread(fd, buf, block_size, i * block_size); }
+    }));
+}
+
+void bench_async(const char* label, bool force_fallback, int fd, unsigned char* bufs) {
+    acpp::uring_file_io io({.queue_depth = 256, .fallback_threads = 4, .force_fallback = force_fallback});
+    std::size_t bytes = 0;
+    auto on_done = [&bytes](int res) { if (res > 0) { bytes += static_cast<std::size_t>(res); } };
+
+    std::string name = std::string(label) + (io.uses_io_uring() ? " [uring]" : " [pool]");
+    report((name + " write").c_str(), seconds([&] {
+        for (std::size_t i = 0; i < block_count; ++i) {
+            io.write(fd, bufs + (i % batch) * block_size, block_size, i * block_size, on_done);
+            if ((i + 1) % batch == 0) { io.submit(); }
+        }
+        io.drain();
+    }));
+    report((name + " read").c_str(), seconds([&] {
+        for (std::size_t i = 0; i < block_count; ++i) {
+            io.read(fd, bufs + (i % batch) * block_size, block_size, i * block_size, on_done);
+            if ((i + 1) % batch == 0) { io.submit(); }
+        }
+        io.drain();
+    }));
+
+    std::vector<iovec> iovs(batch);
+    for (unsigned i = 0; i < batch; ++i) { iovs[i] = {bufs + i * block_size, block_size}; }
+    if (io.register_buffers(iovs) == 0) {
+        report((name + " read_fixed").c_str(), seconds([&] {
+            for (std::size_t i = 0; i < block_count; ++i) {
+                io.read_fixed(fd, static_cast<unsigned>(i % batch), block_size, i * block_size, on_done);
+                if ((i + 1) % batch == 0) { io.submit(); }
+            }
+            io.drain();
+        }));
+    }
+    io.fsync(fd, on_done);
+    io.drain();
+    if (bytes != 3 * block_count * block_size && bytes != 2 * block_count * block_size) {
+        std::cerr << "unexpected byte count " << bytes << '\n';
+    }
+}
+
+} // namespace
+
+int main() {
+    temp_file file;
+    if (file.fd < 0) { std::perror("mkstemp"); return 1; }
+    auto bufs = std::unique_ptr<unsigned char, decltype(&std::free)>(
+        static_cast<unsigned char*>(std::aligned_alloc(block_size, batch * block_size)), &std::free);
+    std::memset(bufs.get(), 0xab, batch * block_size);
+
+    bench_blocking(file.fd, bufs.get());
+    bench_async("uring_file_io", false, file.fd, bufs.get());
+    bench_async("uring_file_io", true, file.fd, bufs.get());
+    return 0;
+}
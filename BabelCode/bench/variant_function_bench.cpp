@@ -0,0 +1,98 @@
+// acpp::variant_function against acpp::function and std::variant + std::visit on call sites
+// that see 1, 2, 4 or 8 callable types, mixed at random over 4096 slots.
+// g++ -std=c++20 -O2 variant_function_bench.cpp -o variant_function_bench
+
+#include "../variant_function.h"
+#include "perf_counters.h"
+
+#include <random>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace {
+
+using acpp::bench::do_not_optimize;
+
+constexpr std::size_t slots = 4096;
+constexpr std::size_t rounds = 256;
+
+// A family of strategies, each its own type, all small enough to inline
+template <int I>
+struct strategy {
+    long factor = I + 1;
+    long operator()(long x) const { return x * factor + I; }
+};
+
+template <typename Container, typename Make>
+Container fill(std::size_t kinds, Make make) {
+    Container out;
+    out.reserve(slots);
+    std::mt19937 rng(1234);
+    for (std::size_t i = 0; i < slots; ++i) { out.push_back(make(kinds == 1 ? 0 : rng() % kinds)); }
+    return out;
+}
+
+template <typename T, int... Is>
+T make_one(std::size_t which, std::integer_sequence<int, Is...>) {
+    T out = strategy<0>{};
+    ((which == static_cast<std::size_t>(Is) ? (out = strategy<Is>{}, 0) : 0), ...);
+    return out;
+}
+
+template <int Kinds, int... Is>
+void run_kinds(acpp::bench::perf_counters& perf, std::integer_sequence<int, Is...> seq) {
+    using variant_fn = acpp::variant_function<long(long), strategy<Is>...>;
+    using std_variant = std::variant<strategy<Is>...>;
+    const uint64_t calls = slots * rounds;
+    char name[64];
+
+    auto variants = fill<std::vector<variant_fn>>(Kinds, [&](std::size_t k) { return make_one<variant_fn>(k, seq); });
+    std::snprintf(name, sizeof(name), "variant_function %d-way", Kinds);
+    perf.run(name, calls, [&] {
+        long acc = 0;
+        for (std::size_t r = 0; r < rounds; ++r) {
+            for (auto& fn : variants) { acc += fn(static_cast<long>(r)); }
+        }
+        do_not_optimize(acc);
+    });
+
+    auto functions = fill<std::vector<acpp::function<long(long)>>>(
+        Kinds, [&](std::size_t k) { return make_one<variant_fn>(k, seq).to_function(); });
+    std::snprintf(name, sizeof(name), "acpp::function %d-way", Kinds);
+    perf.run(name, calls, [&] {
+        long acc = 0;
+        for (std::size_t r = 0; r < rounds; ++r) {
+            for (auto& fn : functions) { acc += fn(static_cast<long>(r)); }
+        }
+        do_not_optimize(acc);
+    });
+
+    auto std_variants = fill<std::vector<std_variant>>(Kinds, [&](std::size_t k) { return make_one<std_variant>(k, seq); });
+    std::snprintf(name, sizeof(name), "std::variant + visit %d-way", Kinds);
+    perf.run(name, calls, [&] {
+        long acc = 0;
+        for (std::size_t r = 0; r < rounds; ++r) {
+            for (auto& v : std_variants) {
+                acc += std::visit([&](auto& fn) { return fn(static_cast<long>(r)); }, v);
+            }
+        }
+        do_not_optimize(acc);
+    });
+}
+
+} // namespace
+
+int main() {
+    acpp::bench::perf_counters perf;
+    perf.print_header();
+    // The variant always lists 8 types; Kinds is how many of them the slots actually use
+    run_kinds<1>(perf, std::make_integer_sequence<int, 8>{});
+    run_kinds<2>(perf, std::make_integer_sequence<int, 8>{});
+    run_kinds<4>(perf, std::make_integer_sequence<int, 8>{});
+    run_kinds<8>(perf, std::make_integer_sequence<int, 8>{});
+    std::printf("\nsizeof: variant_function %zu, acpp::function %zu, std::variant %zu\n",
+                sizeof(acpp::variant_function<long(long), strategy<0>, strategy<1>>),
+                sizeof(acpp::function<long(long)>), sizeof(std::variant<strategy<0>, strategy<1>>));
+    return 0;
+}
@@ -0,0 +1,86 @@
+// Checks acpp::variant_function copy assignment when a callable type can throw on a move: a
+// lambda holding a std::deque, whose move constructor allocates, and a callable whose copy
+// throws on demand. Assignments must copy the callable, and a throwing copy must leave the
+// target valueless and reusable rather than half built.
+// g++ -std=c++20 -O2 variant_function_check.cpp -o variant_function_check
+// ./variant_function_check    exit 0 when every check passes
+
+#include "../variant_function.h"
+
+#include <cstdio>
+#include <deque>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        std::printf("FAILED: %s\n", what);
+        ++failures;
+    }
+}
+
+auto make_sum(std::deque<int> values) {
+    return [values = std::move(values)](int x) {
+        int sum = x;
+        for (int v : values) { sum += v; }
+        return sum;
+    };
+}
+using sum_type = decltype(make_sum({}));
+
+struct scaled {
+    int factor = 2;
+    int operator()(int x) const { return x * factor; }
+};
+
+bool throw_on_copy = false;
+
+struct fragile {
+    fragile() = default;
+    fragile(const fragile&) {
+        if (throw_on_copy) { throw std::runtime_error("copy"); }
+    }
+    fragile(fragile&&) noexcept(false) {}
+    int operator()(int x) const { return -x; }
+};
+
+} // namespace
+
+int main() {
+    static_assert(!std::is_nothrow_move_constructible_v<sum_type>, "the check needs a throwing move");
+    using fn = acpp::variant_function<int(int), scaled, sum_type, fragile>;
+
+    fn a = make_sum({1, 2, 3});
+    fn b = scaled{3};
+    b = a;
+    check(b.holds<sum_type>() && b(10) == 16, "copy assignment across alternatives");
+    fn c = make_sum({100});
+    c = a;
+    check(c(0) == 6 && a(0) == 6, "copy assignment onto the same alternative");
+    c = std::move(b);
+    check(c(1) == 7, "move assignment binds to the copy when moves can throw");
+    c = c;
+    check(c(1) == 7, "self assignment");
+
+    fn thrower = fragile{};
+    throw_on_copy = true;
+    bool threw = false;
+    try {
+        c = thrower;
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    throw_on_copy = false;
+    check(threw && c.valueless_by_exception(), "a throwing copy leaves the target valueless");
+    fn from_valueless = c;
+    check(from_valueless.valueless_by_exception(), "copying a valueless variant_function");
+    c = a;
+    check(!c.valueless_by_exception() && c(0) == 6, "assigning to a valueless variant_function");
+
+    std::printf(failures ? "variant_function checks FAILED\n" : "variant_function checks passed\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+#include "function.h"
+#include "once_function.h"
+
+namespace acpp {
+namespace detail {
+
+// C-ABI entry points for a signature. The function object itself is the context, so
+// nothing is allocated; exceptions can't unwind through C frames and terminate instead.
+template <typename Fn, typename R, typename... Args>
+struct _C_thunks {
+    static R ctx_first(void* ctx, Args... args) noexcept {
+        return (*static_cast<Fn*>(ctx))(std::forward<Args>(args)...);
+    }
+    static R ctx_last(Args... args, void* ctx) noexcept {
+        return (*static_cast<Fn*>(ctx))(std::forward<Args>(args)...);
+    }
+    static R ctx_first_once(void* ctx, Args... args) noexcept {
+        return std::move(*static_cast<Fn*>(ctx))(std::forward<Args>(args)...);
+    }
+};
+
+} // namespace detail
+
+/// Function pointer plus context for C APIs that take the context first: fn(ctx, args...),
+/// e.g. pthread_create or atexit-style hooks. Call it through fn and ctx, or directly.
+template <typename R, typename... Args>
+struct c_callback_t {
+    R (*fn)(void*, Args...);
+    void* ctx;
+
+    R operator()(Args... args) const { return fn(ctx, std::forward<Args>(args)...); }
+};
+
+/// Same for C APIs that take the context last: fn(args..., ctx), e.g. qsort_r
+template <typename R, typename... Args>
+struct c_callback_last_t {
+    R (*fn)(Args..., void*);
+    void* ctx;
+
+    R operator()(Args... args) const { return fn(std::forward<Args>(args)..., ctx); }
+};
+
+/// Bridges a function to a C callback without allocating: ctx is the function object and fn
+/// a per-signature thunk that calls it. Valid as long as f is alive and not moved.
+template <typename R, typename... Args>
+c_callback_t<R, Args...> c_callback(function<R(Args...)>& f) {
+    if (!f) { throw std::runtime_error("bad function call"); }
+    return {&detail::_C_thunks<function<R(Args...)>, R, Args...>::ctx_first, &f};
+}
+
+template <typename R, typename... Args>
+c_callback_last_t<R, Args...> c_callback_ctx_last(function<R(Args...)>& f) {
+    if (!f) { throw std::runtime_error("bad function call"); }
+    return {&detail::_C_thunks<function<R(Args...)>, R, Args...>::ctx_last, &f};
+}
+
+/// For one-shot hooks: the C side may call it once, which destroys the callable
+template <typename R, typename... Args>
+c_callback_t<R, Args...> c_callback(once_function<R(Args...)>& f) {
+    if (!f) { throw std::runtime_error("bad once_function call"); }
+    return {&detail::_C_thunks<once_function<R(Args...)>, R, Args...>::ctx_first_once, &f};
+}
+
+} // namespace acpp
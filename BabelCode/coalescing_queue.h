@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <source_location>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "function.h"
+
+#ifdef ACPP_TRACE
+#include "trace.h"
+#endif
+#ifdef ACPP_TASK_LATENCY
+#include "latency_histogram.h"
+#endif
+
+namespace acpp {
+
+/// Queue of callbacks keyed by what they act on. Posting for a key that is already pending
+/// replaces the pending callable in its slot, or merges into it, instead of queueing another
+/// one; drain() runs one callable per key, in the order the keys were first posted.
+///
+/// Replacing with a callable of the same type assigns over the pending one when the type is
+/// assignable, which reuses a heap spill as well as the inline buffer. Merging is the same
+/// without losing state: merge(pending, incoming) updates the pending callable in place, e.g.
+/// to accumulate the deltas of a burst of config updates into one reload.
+///
+/// post() may be called from any thread; drain() from one thread at a time. Callables posted
+/// while a drain runs, including by the callables themselves, wait for the next drain.
+template <typename Key, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class coalescing_queue {
+public:
+    using callable_type = function<void()>;
+
+    struct stats {
+        uint64_t posted;
+        uint64_t coalesced; // posts that replaced or merged into a pending callable
+        uint64_t executed;
+    };
+
+    coalescing_queue() = default;
+    coalescing_queue(const coalescing_queue&) = delete;
+    coalescing_queue& operator=(const coalescing_queue&) = delete;
+
+    // The source location is only used by ACPP_TRACE builds, to name the key's task, which
+    // runs under the name and site of the post that queued it
+
+    /// Queues callable for key, or replaces the callable already pending for it
+    template <typename Callable>
+        requires std::is_invocable_v<std::decay_t<Callable>&>
+    void post(const Key& key, Callable&& callable, std::source_location location = std::source_location::current()) {
+        using _Clean = std::decay_t<Callable>;
+        if constexpr (std::is_assignable_v<_Clean&, Callable&&>) {
+            post(key, std::forward<Callable>(callable),
+                 [](_Clean& pending, Callable&& incoming) { pending = std::forward<Callable>(incoming); }, location);
+        } else {
+            // Most lambdas aren't assignable: function assignment rebuilds in the same buffer
+            std::lock_guard lock(mutex_);
+            if (callable_type* pending = find_or_push<Callable>(key, callable, location)) {
+                *pending = std::forward<Callable>(callable);
+            }
+        }
+    }
+
+    /// Queues callable for key. If a callable of the same type is pending for key,
+    /// merge(pending, std::forward<Callable>(callable)) combines them in place; a pending
+    /// callable of another type is replaced.
+    template <typename Callable, typename Merge>
+        requires std::is_invocable_v<std::decay_t<Callable>&> &&
+                 std::is_invocable_v<Merge&, std::decay_t<Callable>&, Callable&&>
+    void post(const Key& key, Callable&& callable, Merge&& merge,
+              std::source_location location = std::source_location::current()) {
+        std::lock_guard lock(mutex_);
+        callable_type* pending = find_or_push<Callable>(key, callable, location);
+        if (!pending) { return; }
+        if (auto* same = pending->template target<std::decay_t<Callable>>()) {
+            merge(*same, std::forward<Callable>(callable));
+        } else {
+            *pending = std::forward<Callable>(callable);
+        }
+    }
+
+    /// Runs the pending callables, one per key, and returns how many ran. If one throws, the
+    /// ones after it in this drain are dropped.
+    std::size_t drain() {
+        std::vector<_Pending> batch;
+        {
+            std::lock_guard lock(mutex_);
+            if (pending_.empty()) { return 0; }
+            batch.swap(pending_);
+            pending_.swap(spare_);
+            ++drains_;
+        }
+        struct _Recycle {
+            coalescing_queue& queue;
+            std::vector<_Pending>& batch;
+            ~_Recycle() {
+                batch.clear();
+                // Hand the buffer back so the next burst doesn't grow one from scratch
+                std::lock_guard lock(queue.mutex_);
+                if (queue.spare_.capacity() < batch.capacity()) { queue.spare_.swap(batch); }
+            }
+        } recycle{*this, batch};
+        for (auto& pending : batch) { run(pending); }
+        std::lock_guard lock(mutex_);
+        executed_ += batch.size();
+        return batch.size();
+    }
+
+    std::size_t pending() const {
+        std::lock_guard lock(mutex_);
+        return pending_.size();
+    }
+
+    stats statistics() const {
+        std::lock_guard lock(mutex_);
+        return {posted_, coalesced_, executed_};
+    }
+
+#ifdef ACPP_TASK_LATENCY
+    /// Queue delay (a key's first post to its callable starting) and run time of each callable
+    const task_latency& latency() const noexcept { return latency_; }
+#endif
+
+private:
+    // A queued callable, with its task's state in builds that trace or time tasks
+    struct _Pending {
+        callable_type callable;
+#ifdef ACPP_TRACE
+        uint64_t trace_id{0};
+        trace::task_info trace_task{};
+#endif
+#ifdef ACPP_TASK_LATENCY
+        uint64_t posted_ns{0};
+#endif
+    };
+
+    // The callable pending for key, or null after queueing callable as the key's first post
+    template <typename Callable>
+    callable_type* find_or_push(const Key& key, Callable& callable, [[maybe_unused]] const std::source_location& location) {
+        ++posted_;
+        auto [it, inserted] = index_.try_emplace(key);
+        _Slot& slot = it->second;
+        if (inserted || slot.drain != drains_) {
+            slot = {static_cast<uint32_t>(pending_.size()), drains_};
+            [[maybe_unused]] _Pending& pending = pending_.emplace_back(std::forward<Callable>(callable));
+#ifdef ACPP_TASK_LATENCY
+            pending.posted_ns = detail::_Latency_clock_ns();
+#endif
+#ifdef ACPP_TRACE
+            if (trace::enabled()) [[unlikely]] {
+                pending.trace_task = trace::task_of<std::decay_t<Callable>>(location);
+                pending.trace_id = trace::enqueue(pending.trace_task);
+            }
+#endif
+            return nullptr;
+        }
+        ++coalesced_;
+        return &pending_[slot.index].callable;
+    }
+
+    void run(_Pending& pending) {
+#ifdef ACPP_TASK_LATENCY
+        uint64_t started_ns = detail::_Latency_clock_ns();
+        latency_.queue_delay.record(started_ns - pending.posted_ns);
+        struct _Run_timer {
+            latency_histogram& run_time;
+            uint64_t started_ns;
+            ~_Run_timer() { run_time.record(detail::_Latency_clock_ns() - started_ns); }
+        } run_timer{latency_.run_time, started_ns};
+#endif
+#ifdef ACPP_TRACE
+        if (pending.trace_id) [[unlikely]] {
+            trace::start(pending.trace_id, pending.trace_task);
+            pending.callable();
+            trace::finish(pending.trace_id, pending.trace_task);
+            return;
+        }
+#endif
+        pending.callable();
+    }
+
+    // Entries stay in the index across drains, stamped with the drain they belong to, so a
+    // burst over known keys allocates no map nodes. The index grows with the distinct keys seen.
+    struct _Slot {
+        uint32_t index;
+        uint64_t drain;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<Key, _Slot, Hash, KeyEqual> index_; // key -> slot in pending_
+    std::vector<_Pending> pending_;
+    std::vector<_Pending> spare_;
+    uint64_t posted_{0};
+    uint64_t coalesced_{0};
+    uint64_t executed_{0};
+    uint64_t drains_{0};
+#ifdef ACPP_TASK_LATENCY
+    task_latency latency_;
+#endif
+};
+
+} // namespace acpp
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "function.h"
+
+namespace acpp {
+
+/// Message types expose their type id either as a member function or as a member
+template <typename Msg>
+concept _Has_type_id_fn = requires(const Msg& msg) { { msg.type_id() } -> std::convertible_to<uint32_t>; };
+
+template <typename Msg>
+concept _Has_type_id_member = requires(const Msg& msg) { { msg.type_id } -> std::convertible_to<uint32_t>; };
+
+template <typename Msg>
+    requires _Has_type_id_fn<Msg> || _Has_type_id_member<Msg>
+uint32_t message_type_id(const Msg& msg) noexcept {
+    if constexpr (_Has_type_id_fn<Msg>) {
+        return static_cast<uint32_t>(msg.type_id());
+    } else {
+        return static_cast<uint32_t>(msg.type_id);
+    }
+}
+
+namespace detail {
+
+// Type id -> dense index. Small ids hit a direct table, the rest an open-addressed
+// flat table with linear probing; neither follows a pointer per lookup.
+class _Dense_id_map {
+public:
+    static constexpr uint32_t npos = ~uint32_t{0};
+    static constexpr uint32_t direct_limit = 4096;
+
+    uint32_t find(uint32_t id) const noexcept {
+        if (id < direct_.size()) { return direct_[id]; }
+        if (id < direct_limit || slots_.empty()) { return npos; }
+        std::size_t mask = slots_.size() - 1;
+        for (std::size_t i = _Hash(id) & mask;; i = (i + 1) & mask) {
+            if (slots_[i].id == id) { return slots_[i].index; }
+            if (slots_[i].index == npos) { return npos; }
+        }
+    }
+
+    void insert(uint32_t id, uint32_t index) {
+        if (id < direct_limit) {
+            if (id >= direct_.size()) { direct_.resize(id + 1, npos); }
+            direct_[id] = index;
+            return;
+        }
+        if ((sparse_count_ + 1) * 2 > slots_.size()) { grow(); }
+        place(id, index);
+        ++sparse_count_;
+    }
+
+private:
+    struct _Slot {
+        uint32_t id{0};
+        uint32_t index{npos};
+    };
+
+    static std::size_t _Hash(uint32_t id) noexcept { return (id * 0x9E3779B1u) >> 7; }
+
+    void place(uint32_t id, uint32_t index) noexcept {
+        std::size_t mask = slots_.size() - 1;
+        std::size_t i = _Hash(id) & mask;
+        while (slots_[i].index != npos) { i = (i + 1) & mask; }
+        slots_[i] = {id, index};
+    }
+
+    void grow() {
+        std::vector<_Slot> old = std::exchange(slots_, std::vector<_Slot>(slots_.empty() ? 16 : slots_.size() * 2));
+        for (const _Slot& slot : old) {
+            if (slot.index != npos) { place(slot.id, slot.index); }
+        }
+    }
+
+    std::vector<uint32_t> direct_;
+    std::vector<_Slot> slots_;
+    std::size_t sparse_count_{0};
+};
+
+} // namespace detail
+
+/// Routes messages to handlers by message type id.
+/// Every handler lives in one flat array; the handlers of a type form a contiguous run
+/// found through a dense index, so a dispatch is two array lookups and a linear walk.
+/// Handlers may dispatch again and may subscribe; a handler subscribed while a dispatch is
+/// running takes effect once the outermost dispatch returns. set_fallback() must not be
+/// called from a handler.
+template <typename Msg>
+class dispatcher {
+public:
+    using handler_type = function<void(const Msg&)>;
+
+    template <typename Handler>
+    void subscribe(uint32_t type_id, Handler&& handler) {
+        if (dispatching_) {
+            // Inserting would move the handlers being walked
+            deferred_.push_back({type_id, handler_type(std::forward<Handler>(handler))});
+            return;
+        }
+        apply_deferred();
+        add(type_id, handler_type(std::forward<Handler>(handler)));
+    }
+
+    /// Compile-time id taken from Type::type_id
+    template <typename Type, typename Handler>
+        requires requires { { Type::type_id } -> std::convertible_to<uint32_t>; }
+    void subscribe(Handler&& handler) {
+        subscribe(static_cast<uint32_t>(Type::type_id), std::forward<Handler>(handler));
+    }
+
+    /// Called for messages nobody subscribed to
+    template <typename Handler>
+    void set_fallback(Handler&& handler) { fallback_ = handler_type(std::forward<Handler>(handler)); }
+
+    std::size_t handler_count() const noexcept { return handlers_.size(); }
+    std::size_t type_count() const noexcept { return runs_.size(); }
+
+    void dispatch(const Msg& msg) {
+        {
+            _Dispatch_scope scope(*this);
+            run_handlers(msg);
+        }
+        if (!deferred_.empty() && !dispatching_) [[unlikely]] { apply_deferred(); }
+    }
+
+    /// Groups the batch by type (stable counting sort) and then runs each handler over all
+    /// messages of its type back to back, keeping the indirect call site monomorphic.
+    /// Order is preserved per type and per handler, not across types.
+    void dispatch_batch(std::span<const Msg> msgs) {
+        {
+            _Dispatch_scope scope(*this);
+            // A batch dispatched from a handler sorts in its own scratch
+            _Scratch nested;
+            run_batch(msgs, scope.outermost() ? scratch_ : nested);
+        }
+        if (!deferred_.empty() && !dispatching_) [[unlikely]] { apply_deferred(); }
+    }
+
+private:
+    struct _Run {
+        uint32_t begin;
+        uint32_t count;
+    };
+
+    struct _Deferred {
+        uint32_t type_id;
+        handler_type handler;
+    };
+
+    // Scratch for dispatch_batch, kept to avoid reallocating per batch
+    struct _Scratch {
+        std::vector<uint32_t> dense;
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> order;
+    };
+
+    struct _Dispatch_scope {
+        dispatcher& self;
+        explicit _Dispatch_scope(dispatcher& d) noexcept : self{d} { ++self.dispatching_; }
+        ~_Dispatch_scope() { --self.dispatching_; }
+        bool outermost() const noexcept { return self.dispatching_ == 1; }
+    };
+
+    void apply_deferred() {
+        for (_Deferred& deferred : std::exchange(deferred_, {})) { add(deferred.type_id, std::move(deferred.handler)); }
+    }
+
+    void add(uint32_t type_id, handler_type&& handler) {
+        uint32_t dense = ids_.find(type_id);
+        if (dense == detail::_Dense_id_map::npos) {
+            dense = static_cast<uint32_t>(runs_.size());
+            ids_.insert(type_id, dense);
+            runs_.push_back({static_cast<uint32_t>(handlers_.size()), 0});
+        }
+        // Append at the end of the run and shift the runs that follow; registration is rare
+        _Run& run = runs_[dense];
+        uint32_t pos = run.begin + run.count;
+        handlers_.insert(handlers_.begin() + pos, std::move(handler));
+        ++run.count;
+        for (_Run& other : runs_) {
+            if (&other != &run && other.begin >= pos) { ++other.begin; }
+        }
+    }
+
+    void run_handlers(const Msg& msg) {
+        uint32_t dense = ids_.find(message_type_id(msg));
+        if (dense == detail::_Dense_id_map::npos) {
+            if (fallback_) { fallback_(msg); }
+            return;
+        }
+        const _Run run = runs_[dense];
+        handler_type* handler = handlers_.data() + run.begin;
+        for (handler_type* end = handler + run.count; handler != end; ++handler) { (*handler)(msg); }
+    }
+
+    void run_batch(std::span<const Msg> msgs, _Scratch& scratch) {
+        auto& [dense_of, offsets, order] = scratch;
+        const uint32_t types = static_cast<uint32_t>(runs_.size());
+        const uint32_t unknown = types;
+        dense_of.resize(msgs.size());
+        offsets.assign(types + 2, 0);
+        for (std::size_t i = 0; i < msgs.size(); ++i) {
+            uint32_t dense = ids_.find(message_type_id(msgs[i]));
+            dense_of[i] = dense == detail::_Dense_id_map::npos ? unknown : dense;
+            ++offsets[dense_of[i] + 1];
+        }
+        for (uint32_t t = 0; t <= types; ++t) { offsets[t + 1] += offsets[t]; }
+        order.resize(msgs.size());
+        for (std::size_t i = 0; i < msgs.size(); ++i) {
+            order[offsets[dense_of[i]]++] = static_cast<uint32_t>(i);
+        }
+
+        // offsets[t] now marks the end of group t
+        uint32_t group_begin = 0;
+        for (uint32_t t = 0; t < types; ++t) {
+            uint32_t group_end = offsets[t];
+            const _Run run = runs_[t];
+            for (uint32_t h = run.begin; h < run.begin + run.count; ++h) {
+                handler_type& handler = handlers_[h];
+                for (uint32_t m = group_begin; m < group_end; ++m) { handler(msgs[order[m]]); }
+            }
+            group_begin = group_end;
+        }
+        if (fallback_) {
+            for (uint32_t m = group_begin; m < offsets[unknown]; ++m) { fallback_(msgs[order[m]]); }
+        }
+    }
+
+    detail::_Dense_id_map ids_;
+    std::vector<_Run> runs_;
+    std::vector<handler_type> handlers_;
+    handler_type fallback_;
+    _Scratch scratch_;
+    uint32_t dispatching_{0}; // nesting depth of dispatch and dispatch_batch
+    std::vector<_Deferred> deferred_;
+};
+
+} // namespace acpp
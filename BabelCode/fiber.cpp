@@ -0,0 +1,605 @@
+// Runtime behind acpp::fiber: context switches, the stack pool and the scheduler workers.
+// Link this file into programs that use fiber.h.
+
+#include "fiber.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <new>
+#include <system_error>
+#include <vector>
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "thread.h"
+
+#if defined(__SANITIZE_ADDRESS__)
+#define ACPP_FIBER_ASAN
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define ACPP_FIBER_ASAN
+#endif
+#endif
+#ifdef ACPP_FIBER_ASAN
+#include <sanitizer/asan_interface.h>
+#include <sanitizer/common_interface_defs.h>
+#endif
+#if defined(__SANITIZE_THREAD__)
+#define ACPP_FIBER_TSAN
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define ACPP_FIBER_TSAN
+#endif
+#endif
+#ifdef ACPP_FIBER_TSAN
+#include <sanitizer/tsan_interface.h>
+#endif
+
+namespace acpp::detail {
+extern "C" [[noreturn]] void acpp_fiber_entry(_Fiber* fiber) noexcept;
+}
+
+#ifndef ACPP_FIBER_UCONTEXT
+// acpp_fiber_switch(&from_sp, to_sp) pushes the callee-saved registers and the floating point
+// control state of the running context, stores its stack pointer into from_sp, then loads
+// to_sp and pops the same frame. A new fiber's stack starts with such a frame, built by
+// _Prepare_stack, that "returns" into acpp_fiber_trampoline with the fiber in a callee-saved
+// register.
+extern "C" void acpp_fiber_switch(void** from_sp, void* to_sp) noexcept;
+extern "C" void acpp_fiber_trampoline() noexcept;
+
+#if defined(__x86_64__)
+// Frame, from the saved stack pointer up: mxcsr and x87 control word, r15, r14, r13, r12,
+// rbx, rbp, return address
+asm(R"(
+    .text
+    .globl acpp_fiber_switch
+    .hidden acpp_fiber_switch
+    .type acpp_fiber_switch, @function
+    .p2align 4
+acpp_fiber_switch:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size acpp_fiber_switch, .-acpp_fiber_switch
+
+    .globl acpp_fiber_trampoline
+    .hidden acpp_fiber_trampoline
+    .type acpp_fiber_trampoline, @function
+    .p2align 4
+acpp_fiber_trampoline:
+    movq %r12, %rdi
+    andq $-16, %rsp
+    call acpp_fiber_entry@PLT
+    ud2
+    .size acpp_fiber_trampoline, .-acpp_fiber_trampoline
+)");
+#elif defined(__aarch64__)
+// Frame, 176 bytes from the saved stack pointer up: x19-x28, x29 (frame pointer), x30 (return
+// address), d8-d15, fpcr
+asm(R"(
+    .text
+    .globl acpp_fiber_switch
+    .hidden acpp_fiber_switch
+    .type acpp_fiber_switch, %function
+    .p2align 4
+acpp_fiber_switch:
+    sub sp, sp, #176
+    stp x19, x20, [sp, #0]
+    stp x21, x22, [sp, #16]
+    stp x23, x24, [sp, #32]
+    stp x25, x26, [sp, #48]
+    stp x27, x28, [sp, #64]
+    stp x29, x30, [sp, #80]
+    stp d8, d9, [sp, #96]
+    stp d10, d11, [sp, #112]
+    stp d12, d13, [sp, #128]
+    stp d14, d15, [sp, #144]
+    mrs x9, fpcr
+    str x9, [sp, #160]
+    mov x9, sp
+    str x9, [x0]
+    mov sp, x1
+    ldp x19, x20, [sp, #0]
+    ldp x21, x22, [sp, #16]
+    ldp x23, x24, [sp, #32]
+    ldp x25, x26, [sp, #48]
+    ldp x27, x28, [sp, #64]
+    ldp x29, x30, [sp, #80]
+    ldp d8, d9, [sp, #96]
+    ldp d10, d11, [sp, #112]
+    ldp d12, d13, [sp, #128]
+    ldp d14, d15, [sp, #144]
+    ldr x9, [sp, #160]
+    msr fpcr, x9
+    add sp, sp, #176
+    ret
+    .size acpp_fiber_switch, .-acpp_fiber_switch
+
+    .globl acpp_fiber_trampoline
+    .hidden acpp_fiber_trampoline
+    .type acpp_fiber_trampoline, %function
+    .p2align 4
+acpp_fiber_trampoline:
+    mov x0, x19
+    bl acpp_fiber_entry
+    brk #0
+    .size acpp_fiber_trampoline, .-acpp_fiber_trampoline
+)");
+#endif
+#endif // !ACPP_FIBER_UCONTEXT
+
+namespace acpp::detail {
+
+// What a worker does with the fiber that just switched back to it
+enum class _After : uint8_t { none, reschedule, unlock, finish };
+
+struct _Worker;
+
+// Control block, constructed at the top of the fiber's stack
+struct _Fiber {
+    _Fiber(once_function<void()>&& fn, _Scheduler_state* owner, void* mapping) noexcept
+        : entry{std::move(fn)}, scheduler{owner}, stack{mapping} {}
+
+    _Fiber_context context;
+    once_function<void()> entry;
+    _Scheduler_state* scheduler;
+    void* stack;                      // start of the stack's mapping, guard page included
+    std::atomic<uint32_t> refs{2};    // the fiber handle and the running fiber
+    _Spinlock join_lock;
+    bool done{false};
+    _Waiter* joiner{nullptr};
+#ifdef ACPP_TRACE
+    uint64_t trace_id{0};
+    trace::task_info trace_task{};
+#endif
+#ifdef ACPP_TASK_LATENCY
+    uint64_t ready_ns{0};
+#endif
+};
+
+// Stacks are carved from slabs mapped a few at a time and recycled through a free list; the
+// memory is only committed as the fibers touch it. Each stack has an inaccessible guard page
+// below it, so an overflow faults instead of running into the neighbour.
+class _Stack_pool {
+public:
+    _Stack_pool(std::size_t stack_bytes, bool guard_pages)
+        : page_{static_cast<std::size_t>(::sysconf(_SC_PAGESIZE))},
+          guard_{guard_pages ? page_ : 0},
+          stride_{guard_ + (std::max(stack_bytes, page_) + page_ - 1) / page_ * page_} {}
+
+    _Stack_pool(const _Stack_pool&) = delete;
+    _Stack_pool& operator=(const _Stack_pool&) = delete;
+
+    ~_Stack_pool() {
+        for (void* slab : slabs_) { ::munmap(slab, stride_ * _Stacks_per_slab); }
+    }
+
+    // Total bytes of a stack, guard page included
+    std::size_t stride() const noexcept { return stride_; }
+    std::size_t guard() const noexcept { return guard_; }
+
+    void* acquire() {
+        std::lock_guard lock(mutex_);
+        if (free_.empty()) { grow(); }
+        void* stack = free_.back();
+        free_.pop_back();
+        return stack;
+    }
+
+    void release(void* stack) noexcept {
+#ifdef ACPP_FIBER_ASAN
+        // Frames of the finished fiber leave poisoned redzones behind
+        __asan_unpoison_memory_region(static_cast<char*>(stack) + guard_, stride_ - guard_);
+#endif
+        std::lock_guard lock(mutex_);
+        free_.push_back(stack);
+    }
+
+private:
+    static constexpr std::size_t _Stacks_per_slab = 32;
+
+    void grow() {
+        void* slab = ::mmap(nullptr, stride_ * _Stacks_per_slab, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+        if (slab == MAP_FAILED) { throw std::system_error(errno, std::generic_category(), "acpp::fiber_scheduler: stack mmap"); }
+        free_.reserve(free_.size() + _Stacks_per_slab);
+        slabs_.push_back(slab);
+        // Lowest stack last, so it is handed out first
+        for (std::size_t i = _Stacks_per_slab; i-- > 0;) {
+            char* stack = static_cast<char*>(slab) + i * stride_;
+            if (guard_ && ::mprotect(stack, guard_, PROT_NONE) != 0) {
+                throw std::system_error(errno, std::generic_category(), "acpp::fiber_scheduler: guard page");
+            }
+            free_.push_back(stack);
+        }
+    }
+
+    const std::size_t page_;
+    const std::size_t guard_;
+    const std::size_t stride_;
+    std::mutex mutex_;
+    std::vector<void*> free_;
+    std::vector<void*> slabs_;
+};
+
+// Owner pops from the front of its queue and requeues at the back; thieves take from the back
+struct _Worker {
+    _Scheduler_state* scheduler;
+    std::size_t index;
+    std::mutex mutex;
+    std::deque<_Fiber*> ready;
+    _Fiber_context context;
+    _Fiber* running{nullptr};
+    _After after{_After::none};
+    _Spinlock* after_lock{nullptr};
+    acpp::thread thread;
+};
+
+struct _Scheduler_state {
+    explicit _Scheduler_state(const fiber_scheduler::options& opts)
+        : stacks{opts.stack_bytes, opts.guard_pages} {}
+
+    _Stack_pool stacks;
+    std::vector<std::unique_ptr<_Worker>> workers;
+    std::atomic<std::size_t> next_worker{0}; // round robin for fibers woken off the workers
+
+    // ready_count and sleeping pair up (both seq_cst) so a worker going to sleep either sees
+    // the new fiber or is seen by the thread that queued it
+    std::atomic<std::size_t> ready_count{0};
+    std::atomic<std::size_t> sleeping{0};
+    std::atomic<std::size_t> live{0};
+    std::mutex idle_mutex;
+    std::condition_variable idle_cv;
+    std::condition_variable finished_cv; // live dropped to 0
+    bool stopping{false};
+#ifdef ACPP_TASK_LATENCY
+    task_latency latency;
+#endif
+};
+
+namespace {
+
+thread_local _Worker* _Worker_here = nullptr;
+
+// Fibers migrate between workers, so code running on a fiber must not reuse a thread_local
+// address computed before a switch: every read goes through this opaque call.
+[[gnu::noinline]] _Worker* _This_worker() noexcept {
+    asm volatile("" ::: "memory");
+    return _Worker_here;
+}
+
+void _Switch(_Fiber_context& from, _Fiber_context& to, [[maybe_unused]] bool from_exits) noexcept {
+#ifdef ACPP_FIBER_TSAN
+    __tsan_switch_to_fiber(to.tsan_fiber, 0);
+#endif
+#ifdef ACPP_FIBER_ASAN
+    void* fake_stack = nullptr;
+    __sanitizer_start_switch_fiber(from_exits ? nullptr : &fake_stack, to.stack_bottom, to.stack_size);
+#endif
+#ifdef ACPP_FIBER_UCONTEXT
+    ::swapcontext(&from.uc, &to.uc);
+#else
+    acpp_fiber_switch(&from.sp, to.sp);
+#endif
+#ifdef ACPP_FIBER_ASAN
+    __sanitizer_finish_switch_fiber(fake_stack, nullptr, nullptr);
+#endif
+}
+
+#ifdef ACPP_FIBER_UCONTEXT
+void _Ucontext_entry(unsigned high, unsigned low) noexcept {
+    acpp_fiber_entry(reinterpret_cast<_Fiber*>((static_cast<uintptr_t>(high) << 32) | low));
+}
+#endif
+
+// Builds the control block at the top of a fresh stack and a context that starts the entry
+_Fiber* _Prepare_stack(_Scheduler_state& scheduler, void* stack, once_function<void()>&& entry) {
+    _Stack_pool& pool = scheduler.stacks;
+    char* bottom = static_cast<char*>(stack) + pool.guard();
+    uintptr_t top = reinterpret_cast<uintptr_t>(stack) + pool.stride();
+    top = (top - sizeof(_Fiber)) & ~uintptr_t{63};
+    auto* fiber = new (reinterpret_cast<void*>(top)) _Fiber(std::move(entry), &scheduler, stack);
+    fiber->context.stack_bottom = bottom;
+    fiber->context.stack_size = top - reinterpret_cast<uintptr_t>(bottom);
+#ifdef ACPP_FIBER_TSAN
+    fiber->context.tsan_fiber = __tsan_create_fiber(0);
+#endif
+#ifdef ACPP_FIBER_UCONTEXT
+    ::getcontext(&fiber->context.uc);
+    fiber->context.uc.uc_stack.ss_sp = bottom;
+    fiber->context.uc.uc_stack.ss_size = fiber->context.stack_size;
+    fiber->context.uc.uc_link = nullptr;
+    auto address = reinterpret_cast<uintptr_t>(fiber);
+    ::makecontext(&fiber->context.uc, reinterpret_cast<void (*)()>(&_Ucontext_entry), 2,
+                  static_cast<unsigned>(address >> 32), static_cast<unsigned>(address));
+#elif defined(__x86_64__)
+    auto* frame = reinterpret_cast<uint64_t*>(top - 64);
+    frame[0] = 0x1F80 | (uint64_t{0x037F} << 32); // default mxcsr and x87 control word
+    frame[1] = frame[2] = frame[3] = 0;            // r15, r14, r13
+    frame[4] = reinterpret_cast<uint64_t>(fiber);  // r12
+    frame[5] = frame[6] = 0;                       // rbx, rbp
+    frame[7] = reinterpret_cast<uint64_t>(&acpp_fiber_trampoline);
+    fiber->context.sp = frame;
+#elif defined(__aarch64__)
+    auto* frame = reinterpret_cast<uint64_t*>(top - 176);
+    std::fill_n(frame, 22, uint64_t{0});           // x20-x29, d8-d15 and fpcr start cleared
+    frame[0] = reinterpret_cast<uint64_t>(fiber);  // x19
+    frame[11] = reinterpret_cast<uint64_t>(&acpp_fiber_trampoline); // x30
+    fiber->context.sp = frame;
+#endif
+    return fiber;
+}
+
+void _Release(_Fiber* fiber) noexcept {
+    if (fiber->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        _Stack_pool& pool = fiber->scheduler->stacks;
+        void* stack = fiber->stack;
+#ifdef ACPP_FIBER_TSAN
+        __tsan_destroy_fiber(fiber->context.tsan_fiber);
+#endif
+        std::destroy_at(fiber);
+        pool.release(stack);
+    }
+}
+
+// Queues a ready fiber on the calling worker, or round robin when called from elsewhere
+void _Schedule(_Fiber* fiber) noexcept {
+    _Scheduler_state& scheduler = *fiber->scheduler;
+#ifdef ACPP_TASK_LATENCY
+    fiber->ready_ns = _Latency_clock_ns();
+#endif
+    _Worker* worker = _This_worker();
+    if (!worker || worker->scheduler != &scheduler) {
+        std::size_t next = scheduler.next_worker.fetch_add(1, std::memory_order_relaxed);
+        worker = scheduler.workers[next % scheduler.workers.size()].get();
+    }
+    {
+        std::lock_guard lock(worker->mutex);
+        worker->ready.push_back(fiber);
+    }
+    scheduler.ready_count.fetch_add(1);
+    if (scheduler.sleeping.load() > 0) {
+        std::lock_guard lock(scheduler.idle_mutex);
+        scheduler.idle_cv.notify_one();
+    }
+}
+
+// Switches from the running fiber back to its worker, which then performs action
+void _Suspend(_After action, _Spinlock* lock = nullptr) noexcept {
+    _Worker* worker = _This_worker();
+    worker->after = action;
+    worker->after_lock = lock;
+    _Switch(worker->running->context, worker->context, action == _After::finish);
+}
+
+_Fiber* _Pop(_Worker& worker, bool front) noexcept {
+    std::lock_guard lock(worker.mutex);
+    if (worker.ready.empty()) { return nullptr; }
+    _Fiber* fiber;
+    if (front) {
+        fiber = worker.ready.front();
+        worker.ready.pop_front();
+    } else {
+        fiber = worker.ready.back();
+        worker.ready.pop_back();
+    }
+    worker.scheduler->ready_count.fetch_sub(1, std::memory_order_relaxed);
+    return fiber;
+}
+
+// The next fiber for worker: its own queue, then the others', then sleep. Null once stopping.
+_Fiber* _Next_fiber(_Worker& worker) {
+    _Scheduler_state& scheduler = *worker.scheduler;
+    const std::size_t count = scheduler.workers.size();
+    while (true) {
+        if (_Fiber* fiber = _Pop(worker, true)) { return fiber; }
+        for (std::size_t i = 1; i < count; ++i) {
+            if (_Fiber* fiber = _Pop(*scheduler.workers[(worker.index + i) % count], false)) { return fiber; }
+        }
+        std::unique_lock lock(scheduler.idle_mutex);
+        scheduler.sleeping.fetch_add(1);
+        scheduler.idle_cv.wait(lock, [&] { return scheduler.stopping || scheduler.ready_count.load() > 0; });
+        scheduler.sleeping.fetch_sub(1);
+        if (scheduler.stopping && scheduler.ready_count.load() == 0) { return nullptr; }
+    }
+}
+
+void _Finish(_Fiber* fiber) noexcept {
+    _Scheduler_state& scheduler = *fiber->scheduler;
+    fiber->join_lock.lock();
+    fiber->done = true;
+    _Waiter* joiner = std::exchange(fiber->joiner, nullptr);
+    fiber->join_lock.unlock();
+    if (joiner) { _Wake(*joiner); }
+    _Release(fiber);
+    // Under the mutex, so the destructor's wait can't miss the last one
+    std::lock_guard lock(scheduler.idle_mutex);
+    if (scheduler.live.fetch_sub(1) == 1) { scheduler.finished_cv.notify_all(); }
+}
+
+void _Run_worker(_Worker& worker) {
+    _Worker_here = &worker;
+#ifdef ACPP_FIBER_TSAN
+    worker.context.tsan_fiber = __tsan_get_current_fiber();
+#endif
+#ifdef ACPP_FIBER_ASAN
+    pthread_attr_t attr;
+    if (::pthread_getattr_np(::pthread_self(), &attr) == 0) {
+        void* bottom;
+        std::size_t size;
+        ::pthread_attr_getstack(&attr, &bottom, &size);
+        worker.context.stack_bottom = bottom;
+        worker.context.stack_size = size;
+        ::pthread_attr_destroy(&attr);
+    }
+#endif
+    while (_Fiber* fiber = _Next_fiber(worker)) {
+#ifdef ACPP_TASK_LATENCY
+        uint64_t resumed_ns = _Latency_clock_ns();
+        worker.scheduler->latency.queue_delay.record(resumed_ns - fiber->ready_ns);
+#endif
+#ifdef ACPP_TRACE
+        if (fiber->trace_id) [[unlikely]] { trace::start(fiber->trace_id, fiber->trace_task); }
+#endif
+        worker.running = fiber;
+        _Switch(worker.context, fiber->context, false);
+        worker.running = nullptr;
+        // Recorded here on the worker, and before the after action, which may free the fiber
+#ifdef ACPP_TRACE
+        if (fiber->trace_id) [[unlikely]] { trace::finish(fiber->trace_id, fiber->trace_task); }
+#endif
+#ifdef ACPP_TASK_LATENCY
+        worker.scheduler->latency.run_time.record(_Latency_clock_ns() - resumed_ns);
+#endif
+        switch (std::exchange(worker.after, _After::none)) {
+        case _After::reschedule: _Schedule(fiber); break;
+        case _After::unlock: worker.after_lock->unlock(); break;
+        case _After::finish: _Finish(fiber); break;
+        case _After::none: break;
+        }
+    }
+    _Worker_here = nullptr;
+}
+
+} // namespace
+
+extern "C" [[noreturn]] void acpp_fiber_entry(_Fiber* fiber) noexcept {
+#ifdef ACPP_FIBER_ASAN
+    __sanitizer_finish_switch_fiber(nullptr, nullptr, nullptr);
+#endif
+    // An exception escaping the entry terminates, as with acpp::thread
+    std::move(fiber->entry)();
+    _Suspend(_After::finish);
+    std::abort();
+}
+
+_Fiber* _Current_fiber() noexcept {
+    _Worker* worker = _This_worker();
+    return worker ? worker->running : nullptr;
+}
+
+void _Park(_Waiter& waiter, _Spinlock& list_lock) noexcept {
+    if (waiter.fiber) {
+        _Suspend(_After::unlock, &list_lock);
+        return;
+    }
+    list_lock.unlock();
+    waiter.woken.wait();
+}
+
+void _Wake(_Waiter& waiter) noexcept {
+    // A woken waiter may return and pop its stack frame at once: read it first
+    if (_Fiber* fiber = waiter.fiber) {
+        _Schedule(fiber);
+        return;
+    }
+    waiter.woken.notify(); // the waiter returns only once notify() is done with it
+}
+
+} // namespace acpp::detail
+
+namespace acpp {
+
+void fiber::join() {
+    if (!fiber_) { throw std::system_error(std::make_error_code(std::errc::invalid_argument), "acpp::fiber::join"); }
+    fiber_->join_lock.lock();
+    if (fiber_->done) {
+        fiber_->join_lock.unlock();
+    } else {
+        detail::_Waiter waiter{detail::_Current_fiber()};
+        fiber_->joiner = &waiter;
+        detail::_Park(waiter, fiber_->join_lock);
+    }
+    detail::_Release(std::exchange(fiber_, nullptr));
+}
+
+void fiber::detach() {
+    if (!fiber_) { throw std::system_error(std::make_error_code(std::errc::invalid_argument), "acpp::fiber::detach"); }
+    detail::_Release(std::exchange(fiber_, nullptr));
+}
+
+fiber_scheduler::fiber_scheduler(options opts) : state_{std::make_unique<detail::_Scheduler_state>(opts)} {
+    std::size_t count = opts.workers ? opts.workers : std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t i = 0; i < count; ++i) {
+        state_->workers.push_back(std::make_unique<detail::_Worker>());
+        state_->workers.back()->scheduler = state_.get();
+        state_->workers.back()->index = i;
+    }
+    // Started once the vector is complete, since workers steal from each other
+    for (auto& worker : state_->workers) {
+        worker->thread = acpp::thread([&worker = *worker] { detail::_Run_worker(worker); });
+    }
+}
+
+fiber_scheduler::~fiber_scheduler() {
+    {
+        std::unique_lock lock(state_->idle_mutex);
+        state_->finished_cv.wait(lock, [&] { return state_->live.load() == 0; });
+        state_->stopping = true;
+    }
+    state_->idle_cv.notify_all();
+    for (auto& worker : state_->workers) { worker->thread.join(); }
+}
+
+fiber fiber_scheduler::spawn_entry(once_function<void()> entry) {
+    detail::_Fiber* created = detail::_Prepare_stack(*state_, state_->stacks.acquire(), std::move(entry));
+    state_->live.fetch_add(1);
+    detail::_Schedule(created);
+    return fiber(created);
+}
+
+#ifdef ACPP_TRACE
+fiber fiber_scheduler::spawn_entry(once_function<void()> entry, const trace::task_info& task) {
+    detail::_Fiber* created = detail::_Prepare_stack(*state_, state_->stacks.acquire(), std::move(entry));
+    created->trace_task = task;
+    created->trace_id = trace::enqueue(task);
+    state_->live.fetch_add(1);
+    detail::_Schedule(created);
+    return fiber(created);
+}
+#endif
+
+std::size_t fiber_scheduler::live_fibers() const noexcept { return state_->live.load(std::memory_order_relaxed); }
+
+#ifdef ACPP_TASK_LATENCY
+const task_latency& fiber_scheduler::latency() const noexcept { return state_->latency; }
+#endif
+
+namespace this_fiber {
+
+void yield() {
+    if (detail::_Current_fiber()) {
+        detail::_Suspend(detail::_After::reschedule);
+    } else {
+        std::this_thread::yield();
+    }
+}
+
+bool in_fiber() noexcept { return detail::_Current_fiber() != nullptr; }
+
+} // namespace this_fiber
+} // namespace acpp
@@ -0,0 +1,280 @@
+#pragma once
+
+// Stackful fibers for blocking-style code that can't become coroutines: each fiber runs on its
+// own pooled stack (guard page below) and is switched in user space, so many fibers share a
+// few worker threads. A fiber_scheduler owns the workers; each has a ready queue, and idle
+// workers steal from the others. Blocking a fiber on a fiber_mutex, a fiber_condition_variable
+// or a join parks it and frees its worker for the next ready fiber.
+// Link fiber.cpp. Context switches are hand written for x86-64 and AArch64 and use ucontext
+// elsewhere, or everywhere with -DACPP_FIBER_UCONTEXT. ASan and TSan builds annotate the
+// switches. ACPP_TRACE and ACPP_TASK_LATENCY must be set alike for fiber.cpp and its users.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "once_function.h"
+#include "thread.h"
+
+#ifdef ACPP_TRACE
+#include "trace.h"
+#endif
+#ifdef ACPP_TASK_LATENCY
+#include "latency_histogram.h"
+#endif
+
+#if !defined(ACPP_FIBER_UCONTEXT) && !defined(__x86_64__) && !defined(__aarch64__)
+#define ACPP_FIBER_UCONTEXT
+#endif
+#ifdef ACPP_FIBER_UCONTEXT
+#include <ucontext.h>
+#endif
+
+namespace acpp {
+
+class fiber_scheduler;
+
+namespace detail {
+
+struct _Fiber;
+struct _Scheduler_state;
+
+// Saved machine state of a suspended fiber or of a worker thread running one
+struct _Fiber_context {
+#ifdef ACPP_FIBER_UCONTEXT
+    ucontext_t uc;
+#else
+    void* sp{nullptr};
+#endif
+    // Stack bounds, for the ASan annotations
+    const void* stack_bottom{nullptr};
+    std::size_t stack_size{0};
+    void* tsan_fiber{nullptr}; // TSan builds only
+};
+
+// Guards the short critical sections of the wait lists; yields the CPU after a few spins
+class _Spinlock {
+public:
+    void lock() noexcept {
+        for (int spins = 0; flag_.exchange(true, std::memory_order_acquire); ++spins) {
+            if (spins >= 64) { std::this_thread::yield(); }
+        }
+    }
+    bool try_lock() noexcept { return !flag_.exchange(true, std::memory_order_acquire); }
+    void unlock() noexcept { flag_.store(false, std::memory_order_release); }
+
+private:
+    std::atomic<bool> flag_{false};
+};
+
+// A blocked fiber, or a thread outside any scheduler, in a wait list. Lives on its stack.
+struct _Waiter {
+    explicit _Waiter(_Fiber* waiting) noexcept : fiber{waiting} {}
+
+    _Fiber* fiber;
+    _Handshake woken; // threads only
+    _Waiter* next{nullptr};
+};
+
+class _Wait_list {
+public:
+    bool empty() const noexcept { return head_ == nullptr; }
+    void push(_Waiter& waiter) noexcept {
+        waiter.next = nullptr;
+        (tail_ ? tail_->next : head_) = &waiter;
+        tail_ = &waiter;
+    }
+    _Waiter* pop() noexcept {
+        _Waiter* waiter = head_;
+        if (waiter && !(head_ = waiter->next)) { tail_ = nullptr; }
+        return waiter;
+    }
+
+private:
+    _Waiter* head_{nullptr};
+    _Waiter* tail_{nullptr};
+};
+
+// Defined in fiber.cpp
+_Fiber* _Current_fiber() noexcept;
+// Blocks until _Wake(waiter). list_lock is held on entry and released once the waiter
+// can safely be woken, i.e. after a fiber has fully switched out.
+void _Park(_Waiter& waiter, _Spinlock& list_lock) noexcept;
+void _Wake(_Waiter& waiter) noexcept;
+
+} // namespace detail
+
+/// Handle to a fiber, like acpp::thread: join or detach it before it is destroyed, and before
+/// its scheduler is.
+class fiber {
+public:
+    fiber() noexcept = default;
+    fiber(const fiber&) = delete;
+    fiber& operator=(const fiber&) = delete;
+    fiber(fiber&& oth) noexcept : fiber_{std::exchange(oth.fiber_, nullptr)} {}
+    fiber& operator=(fiber&& oth) noexcept {
+        if (fiber_) { std::terminate(); }
+        fiber_ = std::exchange(oth.fiber_, nullptr);
+        return *this;
+    }
+    ~fiber() {
+        if (fiber_) { std::terminate(); }
+    }
+
+    bool joinable() const noexcept { return fiber_ != nullptr; }
+
+    /// Waits for the fiber to finish: parks when called from a fiber, blocks a plain thread
+    void join();
+    void detach();
+
+private:
+    friend class fiber_scheduler;
+    explicit fiber(detail::_Fiber* f) noexcept : fiber_{f} {}
+
+    detail::_Fiber* fiber_{nullptr};
+};
+
+/// Runs fibers on a set of worker threads. Destroying it waits for every fiber to finish;
+/// it must not be destroyed from one of its own fibers.
+class fiber_scheduler {
+public:
+    struct options {
+        std::size_t workers = 0;          // 0: one per hardware thread
+        std::size_t stack_bytes = 64 * 1024;
+        bool guard_pages = true;          // an inaccessible page below every stack
+    };
+
+    fiber_scheduler() : fiber_scheduler(options{}) {}
+    explicit fiber_scheduler(options opts);
+    fiber_scheduler(const fiber_scheduler&) = delete;
+    fiber_scheduler& operator=(const fiber_scheduler&) = delete;
+    ~fiber_scheduler();
+
+    /// Starts a fiber; the entry is kept inline in the fiber's control block at its stack top.
+    /// The source location is only used by ACPP_TRACE builds, to name the fiber's task.
+    template <typename Callable> requires _Is_valid_once_callable<Callable, void>
+    fiber spawn(Callable&& callable, [[maybe_unused]] std::source_location location = std::source_location::current()) {
+#ifdef ACPP_TRACE
+        if (trace::enabled()) [[unlikely]] {
+            return spawn_entry(once_function<void()>(std::forward<Callable>(callable)),
+                               trace::task_of<std::decay_t<Callable>>(location));
+        }
+#endif
+        return spawn_entry(once_function<void()>(std::forward<Callable>(callable)));
+    }
+
+    /// Fibers started and not yet finished
+    std::size_t live_fibers() const noexcept;
+
+#ifdef ACPP_TASK_LATENCY
+    /// Queue delay (made ready by spawn, wake or yield, to resumed) and run time of every
+    /// stretch a fiber runs between two switches
+    const task_latency& latency() const noexcept;
+#endif
+
+private:
+    fiber spawn_entry(once_function<void()> entry);
+#ifdef ACPP_TRACE
+    // Traced fibers appear as one slice per stretch they run on a worker
+    fiber spawn_entry(once_function<void()> entry, const trace::task_info& task);
+#endif
+
+    std::unique_ptr<detail::_Scheduler_state> state_;
+};
+
+namespace this_fiber {
+
+/// Lets the other ready fibers of this worker run; a plain thread yields its time slice
+void yield();
+
+bool in_fiber() noexcept;
+
+} // namespace this_fiber
+
+/// Mutex that parks the calling fiber instead of blocking its worker thread. Ownership is
+/// handed directly to the longest waiter on unlock. Plain threads may use it too.
+class fiber_mutex {
+public:
+    fiber_mutex() = default;
+    fiber_mutex(const fiber_mutex&) = delete;
+    fiber_mutex& operator=(const fiber_mutex&) = delete;
+
+    void lock() {
+        lock_.lock();
+        if (!locked_) {
+            locked_ = true;
+            lock_.unlock();
+            return;
+        }
+        detail::_Waiter waiter{detail::_Current_fiber()};
+        waiters_.push(waiter);
+        detail::_Park(waiter, lock_);
+    }
+
+    bool try_lock() noexcept {
+        std::lock_guard guard(lock_);
+        return !std::exchange(locked_, true);
+    }
+
+    void unlock() noexcept {
+        lock_.lock();
+        detail::_Waiter* next = waiters_.pop();
+        if (!next) { locked_ = false; }
+        lock_.unlock();
+        if (next) { detail::_Wake(*next); }
+    }
+
+private:
+    detail::_Spinlock lock_;
+    bool locked_{false};
+    detail::_Wait_list waiters_;
+};
+
+/// Condition variable for fiber_mutex; waiting parks the fiber
+class fiber_condition_variable {
+public:
+    fiber_condition_variable() = default;
+    fiber_condition_variable(const fiber_condition_variable&) = delete;
+    fiber_condition_variable& operator=(const fiber_condition_variable&) = delete;
+
+    void wait(std::unique_lock<fiber_mutex>& lock) {
+        detail::_Waiter waiter{detail::_Current_fiber()};
+        lock_.lock();
+        waiters_.push(waiter);
+        // Queued before the mutex is released, so a notify in between can't be missed
+        lock.mutex()->unlock();
+        detail::_Park(waiter, lock_);
+        lock.mutex()->lock();
+    }
+
+    template <typename Predicate>
+    void wait(std::unique_lock<fiber_mutex>& lock, Predicate stop_waiting) {
+        while (!stop_waiting()) { wait(lock); }
+    }
+
+    void notify_one() noexcept {
+        lock_.lock();
+        detail::_Waiter* waiter = waiters_.pop();
+        lock_.unlock();
+        if (waiter) { detail::_Wake(*waiter); }
+    }
+
+    void notify_all() noexcept {
+        lock_.lock();
+        detail::_Wait_list all = std::exchange(waiters_, {});
+        lock_.unlock();
+        while (detail::_Waiter* waiter = all.pop()) { detail::_Wake(*waiter); }
+    }
+
+private:
+    detail::_Spinlock lock_;
+    detail::_Wait_list waiters_;
+};
+
+} // namespace acpp
@@ -0,0 +1,30 @@
+// C++20 module interface for acpp::function.
+// g++ -std=c++20 -fmodules-ts -c -x c++ function.cppm, then `import acpp.function;`
+// g++ 12 does not make placement new visible to importers: include <new> before the import.
+
+module;
+
+// Standard headers stay in the global module fragment
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#ifdef ACPP_FUNCTION_PROFILE
+#include "function_profile.h"
+#endif
+#ifdef ACPP_FUNCTION_CAPACITY
+#include "function_capacity.h"
+#endif
+#ifdef ACPP_RT_CHECK
+#include "rt_scope.h"
+#include "type_name.h"
+#endif
+
+export module acpp.function;
+
+#define ACPP_FUNCTION_EXPORT export
+#include "function.h"
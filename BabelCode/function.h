@@ -1,10 +1,30 @@
-#include <iostream>
-#include <memory> 
+#pragma once
+
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
 #include <type_traits>
-#include <functional>
 #include <utility>
 
+#ifdef ACPP_FUNCTION_PROFILE
+#include "function_profile.h"
+#endif
+#ifdef ACPP_FUNCTION_CAPACITY
+#include "function_capacity.h"
+#endif
+#ifdef ACPP_RT_CHECK
+#include "rt_scope.h"
+#include "type_name.h"
+#endif
+
+// Expands to export when this header is compiled into the acpp.function module (function.cppm)
+#ifndef ACPP_FUNCTION_EXPORT
+#define ACPP_FUNCTION_EXPORT
+#endif
+
 namespace acpp {
 namespace detail {
 
@@ -16,7 +36,7 @@ struct _Callable_storage {
 };
 
 struct _Any_callable {
-    _Callable_storage storage;
+    _Callable_storage storage{};
     _Operations* operations{nullptr};
 };
 
@@ -26,8 +46,16 @@ concept _In_place_callable = sizeof(T) <= sizeof(_Any_callable::storage) &&
                              std::alignment_of<_Callable_storage>::value % std::alignment_of<T>::value == 0 &&
                              std::is_nothrow_move_constructible<T>::value;
 
+// Default home of the callables that can't be stored in the local buffer
+struct _Heap_spill {
+    template <typename T, typename... CtorArgs>
+    static T* create(CtorArgs&&... args) { return new T(std::forward<CtorArgs>(args)...); }
+    template <typename T>
+    static void destroy(T* ptr) { delete ptr; }
+};
+
 // Handle the callables that can't be stored in the local buffer
-template <typename LargeCallable>
+template <typename LargeCallable, typename Spill = _Heap_spill>
 struct _Any_callable_manager {
     static LargeCallable*& get_ptr(const _Any_callable& any_callable) noexcept {
         return *const_cast<LargeCallable**>(
@@ -38,34 +66,51 @@ struct _Any_callable_manager {
     } 
     template <typename R, typename... Args>
     static R invoke(const _Any_callable& any_callable, Args... args) {
+#ifdef ACPP_RT_CHECK
+        _Rt_callable_frame frame{_Type_name_v<LargeCallable>};
+#endif
         return get_ref(any_callable)(std::forward<Args>(args)...);
     }
     template <typename _Fn>
     static void store(_Fn&& callable, _Any_callable& any_callable) {
-        get_ptr(any_callable) = new LargeCallable(std::forward<_Fn>(callable));
+#ifdef ACPP_RT_CHECK
+        // Constructing or copying a large callable allocates through Spill
+        _Rt_callable_frame frame{_Type_name_v<LargeCallable>};
+#endif
+        get_ptr(any_callable) = Spill::template create<LargeCallable>(std::forward<_Fn>(callable));
     }
     static void move_and_destroy(_Any_callable& dest, _Any_callable& src) noexcept {
         dest.storage = src.storage;
         dest.operations = std::exchange(src.operations, nullptr);
     }
     static void destroy(_Any_callable& any_callable) {
-        delete get_ptr(any_callable);
+#ifdef ACPP_RT_CHECK
+        _Rt_callable_frame frame{_Type_name_v<LargeCallable>};
+#endif
+        Spill::destroy(get_ptr(any_callable));
     }
 };
 
 // Handle the callables that can be stored in the local buffer
-template <typename Callable> requires _In_place_callable<Callable>
-struct _Any_callable_manager<Callable> {
+template <typename Callable, typename Spill> requires _In_place_callable<Callable>
+struct _Any_callable_manager<Callable, Spill> {
     static Callable& get_ref(const _Any_callable& any_callable) noexcept {
         return const_cast<Callable&>(
             reinterpret_cast<const Callable&>(any_callable.storage));
     }
     template <typename R, typename... Args>
     static R invoke(const _Any_callable& any_callable, Args... args) {
+#ifdef ACPP_RT_CHECK
+        _Rt_callable_frame frame{_Type_name_v<Callable>};
+#endif
         return get_ref(any_callable)(std::forward<Args>(args)...);
     }
     template <typename _Fn>
     static void store(_Fn&& callable, _Any_callable& any_callable) {
+#ifdef ACPP_RT_CHECK
+        // No allocation here, but the callable's own copy constructor may allocate
+        _Rt_callable_frame frame{_Type_name_v<Callable>};
+#endif
         new (&get_ref(any_callable)) Callable(std::forward<_Fn>(callable));
     }
     static void move_and_destroy(_Any_callable& dest, _Any_callable& src) {
@@ -78,29 +123,115 @@ struct _Any_callable_manager<Callable> {
     }
 };
 
+// Callables whose copy and destroy are plain byte operations
+template <typename T>
+concept _Trivial_callable = std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value;
+
+// What a spilled trivial callable is allocated as, so that every callable of its size and
+// alignment can be copied and freed by the same code
+template <std::size_t Size, std::size_t Align>
+struct _Trivial_bytes {
+    _Trivial_bytes() noexcept {} // left uninitialized, the callable is built over it
+    alignas(Align) std::byte data[Size];
+};
+
+template <typename T>
+inline constexpr bool _Is_trivial_bytes = false;
+template <std::size_t Size, std::size_t Align>
+inline constexpr bool _Is_trivial_bytes<_Trivial_bytes<Size, Align>> = true;
+
+// Spill policy adaptor behind acpp::shared_ops: allocates through Spill, trivial callables
+// as _Trivial_bytes
+template <typename Spill>
+struct _Shared_ops : Spill {
+    template <typename T, typename... CtorArgs>
+    static T* create(CtorArgs&&... args) {
+        if constexpr (_Trivial_callable<T> && !_Is_trivial_bytes<T>) {
+            auto* bytes = Spill::template create<_Trivial_bytes<sizeof(T), alignof(T)>>();
+            return new (bytes->data) T(std::forward<CtorArgs>(args)...);
+        } else {
+            return Spill::template create<T>(std::forward<CtorArgs>(args)...);
+        }
+    }
+    template <typename T>
+    static void destroy(T* ptr) {
+        if constexpr (_Trivial_callable<T> && !_Is_trivial_bytes<T>) {
+            Spill::destroy(std::launder(reinterpret_cast<_Trivial_bytes<sizeof(T), alignof(T)>*>(ptr)));
+        } else {
+            Spill::destroy(ptr);
+        }
+    }
+};
+
+template <typename Spill>
+inline constexpr bool _Shares_ops = false;
+template <typename Spill>
+inline constexpr bool _Shares_ops<_Shared_ops<Spill>> = true;
+
 /// Acts like a virtual table
 struct _Operations {
-    template <typename Callable>
+    template <typename Callable, typename Spill = _Heap_spill>
     static _Operations& create_operations() {
-        static _Operations vtable;
-        vtable.destroy = &templated_destroy<Callable>;
-        vtable.copy = &templated_copy<Callable>;
-        vtable.move = &templated_move<Callable>;
-        return vtable;
+        if constexpr (_Shares_ops<Spill> && _Trivial_callable<Callable>) {
+            // One table for every trivial in-place callable, one per size and alignment for
+            // the spilled ones
+            if constexpr (_In_place_callable<Callable>) {
+                return trivial_operations();
+            } else {
+                return trivial_spilled_operations<sizeof(Callable), alignof(Callable), Spill>();
+            }
+        } else if constexpr (_Shares_ops<Spill> && !_In_place_callable<Callable>) {
+            // Copy and destroy are the type's own, but moving a spilled callable moves a pointer
+            static _Operations vtable{&templated_destroy<Callable, Spill>,
+                                      &templated_copy<Callable, Spill>,
+                                      &trivial_move};
+            return vtable;
+        } else {
+            static _Operations vtable{&templated_destroy<Callable, Spill>,
+                                      &templated_copy<Callable, Spill>,
+                                      &templated_move<Callable, Spill>};
+            return vtable;
+        }
     }
+    // The same managers without copy, for move-only wrappers such as once_function
     template <typename Callable>
+    static const _Operations& create_move_only_operations() noexcept {
+        static constexpr _Operations vtable{&templated_destroy<Callable, _Heap_spill>, nullptr,
+                                            &templated_move<Callable, _Heap_spill>};
+        return vtable;
+    }
+    static _Operations& trivial_operations() {
+        static _Operations vtable{&trivial_destroy, &trivial_copy, &trivial_move};
+        return vtable;
+    }
+    template <std::size_t Size, std::size_t Align, typename Spill>
+    static _Operations& trivial_spilled_operations() {
+        using _Bytes = _Trivial_bytes<Size, Align>;
+        static _Operations vtable{&templated_destroy<_Bytes, Spill>, &templated_copy<_Bytes, Spill>, &trivial_move};
+        return vtable;
+    }
+    template <typename Callable, typename Spill>
     static void templated_destroy(_Any_callable& any_callable) {
-        _Any_callable_manager<Callable>::destroy(any_callable);
+        _Any_callable_manager<Callable, Spill>::destroy(any_callable);
     }
-    template <typename Callable>
+    template <typename Callable, typename Spill>
     static void templated_copy(_Any_callable& dst, const _Any_callable& src) {
-        using _Manager = _Any_callable_manager<Callable>;
+        using _Manager = _Any_callable_manager<Callable, Spill>;
         _Manager::store(_Manager::get_ref(src), dst);
         dst.operations = src.operations;
     }
-    template <typename Callable>
+    template <typename Callable, typename Spill>
     static void templated_move(_Any_callable& dst, _Any_callable& src) {
-        _Any_callable_manager<Callable>::move_and_destroy(dst, src);
+        _Any_callable_manager<Callable, Spill>::move_and_destroy(dst, src);
+    }
+    static void trivial_destroy(_Any_callable&) {}
+    static void trivial_copy(_Any_callable& dst, const _Any_callable& src) {
+        dst.storage = src.storage;
+        dst.operations = src.operations;
+    }
+    static void trivial_move(_Any_callable& dst, _Any_callable& src) {
+        dst.storage = src.storage;
+        dst.operations = std::exchange(src.operations, nullptr);
     }
     void (*destroy)(_Any_callable& any_callable);
     void (*copy)(_Any_callable& dst, const _Any_callable& src);
@@ -109,73 +240,143 @@ struct _Operations {
 
 } // namespace detail
 
-template <typename... Args>
-class function;
+/// Spill policy: where callables too big for the local buffer are allocated
+ACPP_FUNCTION_EXPORT using heap_spill = detail::_Heap_spill;
+
+/// Spill policy adaptor that shares the erased operations (copy, move, destroy) between
+/// callable types that need the same ones, to cut the code every lambda type instantiates:
+/// trivially copyable in-place callables share one table, spilled ones one per size and
+/// alignment, and every spilled callable shares its move. Other in-place callables keep
+/// their own constructors and destructors.
+///
+///     using compact = acpp::basic_function<void(int), acpp::shared_ops<>>;
+ACPP_FUNCTION_EXPORT template <typename Spill = heap_spill>
+using shared_ops = detail::_Shared_ops<Spill>;
+
+ACPP_FUNCTION_EXPORT template <typename Signature, typename Spill = heap_spill>
+class basic_function;
+
+ACPP_FUNCTION_EXPORT template <typename Signature>
+using function = basic_function<Signature>;
 
-template <typename Callable, typename R, typename... Args>
+ACPP_FUNCTION_EXPORT template <typename Callable, typename R, typename... Args>
 concept _Is_valid_callable = 
     // Callable to match the signature
     std::same_as<std::invoke_result_t<Callable, Args...>, R> &&
     // Different than function to distinguish from the copy constructor 
     !std::is_same_v<std::remove_cvref_t<Callable>, function<R(Args...)>>;
 
-template <typename R, typename... Args>
-class function<R(Args...)> {
+template <typename R, typename... Args, typename Spill>
+class basic_function<R(Args...), Spill> {
 private:
     using _Callable_invoker = R (*)(const detail::_Any_callable&, Args...);
     
 public:
-    function() noexcept = default;
-    function(const function& oth) {
+    basic_function() noexcept = default;
+    basic_function(const basic_function& oth) {
         if (oth) {
             oth.any_callable_.operations->copy(any_callable_, oth.any_callable_);
             invoker_ = oth.invoker_;
+#ifdef ACPP_FUNCTION_PROFILE
+            profile_site_ = oth.profile_site_;
+#endif
         }
     }
-    function(function&& oth) noexcept {
+    basic_function(basic_function&& oth) noexcept {
         if (oth) {
             oth.any_callable_.operations->move(any_callable_, oth.any_callable_);
             invoker_ = std::exchange(oth.invoker_, nullptr);
+#ifdef ACPP_FUNCTION_PROFILE
+            profile_site_ = oth.profile_site_;
+#endif
         }
     }
-    function& operator=(function oth) { swap(oth); return *this; }
+    basic_function& operator=(basic_function oth) { swap(oth); return *this; }
 
-    template <typename Callable> requires _Is_valid_callable<Callable, R, Args...>
-    function(Callable&& callable) { set(std::forward<Callable>(callable)); }
+    template <typename Callable>
+        requires _Is_valid_callable<Callable, R, Args...> &&
+                 (!std::is_same_v<std::remove_cvref_t<Callable>, basic_function>)
+#ifdef ACPP_FUNCTION_PROFILE
+    // Profiled builds attribute calls to the place the function was constructed
+    basic_function(Callable&& callable, std::source_location location = std::source_location::current()) {
+        set(std::forward<Callable>(callable));
+        profile_site_ = detail::_Profile_registry::instance().site<std::decay_t<Callable>>(location);
+    }
+#else
+    basic_function(Callable&& callable) { set(std::forward<Callable>(callable)); }
+#endif
 
     template <typename Callable>
-    function& operator=(Callable&& callable) {
+        requires _Is_valid_callable<Callable, R, Args...> &&
+                 (!std::is_same_v<std::remove_cvref_t<Callable>, basic_function>)
+    basic_function& operator=(Callable&& callable) {
         if (*this) { unset(); }
         set(std::forward<Callable>(callable));
+#ifdef ACPP_FUNCTION_PROFILE
+        // operator= can't take a source_location, assigned callables are keyed by type only
+        profile_site_ = detail::_Profile_registry::instance().site<std::decay_t<Callable>>(std::source_location{});
+#endif
+        return *this;
     }
 
-    ~function() { if (*this) { unset(); } }
+    ~basic_function() { if (*this) { unset(); } }
 
     R operator()(Args... args) {
         if (!any_callable_.operations) {
             throw std::runtime_error("bad function call");
         }
+#ifdef ACPP_FUNCTION_PROFILE
+        detail::_Profile_scope profile{profile_site_};
+#endif
         return (*invoker_)(any_callable_, std::forward<Args>(args)...);
     }
 
     operator bool() const noexcept { return any_callable_.operations != nullptr; }
 
-    void swap(function& oth) noexcept {
+    // Same callable type (same invoker, vtables may be shared) and bitwise identical storage.
+    // Heap-spilled callables only compare equal to themselves.
+    bool same_target(const basic_function& oth) const noexcept {
+        return invoker_ == oth.invoker_ &&
+               any_callable_.operations == oth.any_callable_.operations &&
+               std::memcmp(&any_callable_.storage, &oth.any_callable_.storage,
+                           sizeof(detail::_Callable_storage)) == 0;
+    }
+
+    /// The stored callable if it is a Callable, otherwise null
+    template <typename Callable>
+    Callable* target() noexcept {
+        if constexpr (std::is_invocable_r_v<R, Callable&, Args...>) {
+            using _Manager = detail::_Any_callable_manager<Callable, Spill>;
+            if (invoker_ == &_Manager::template invoke<R, Args...>) { return &_Manager::get_ref(any_callable_); }
+        }
+        return nullptr;
+    }
+    template <typename Callable>
+    const Callable* target() const noexcept { return const_cast<basic_function*>(this)->template target<Callable>(); }
+
+    void swap(basic_function& oth) noexcept {
         detail::_Any_callable temp_callable;
         if (oth) { oth.any_callable_.operations->move(temp_callable, oth.any_callable_); }
         if (*this) { any_callable_.operations->move(oth.any_callable_, any_callable_); }
         if (temp_callable.operations) { temp_callable.operations->move(any_callable_, temp_callable); }
         std::swap(invoker_, oth.invoker_);
+#ifdef ACPP_FUNCTION_PROFILE
+        std::swap(profile_site_, oth.profile_site_);
+#endif
     }
 
 private:
     template <typename Callable>
     void set(Callable&& callable) {
         using _CleanCallable = std::decay_t<Callable>;
-        using _Manager = detail::_Any_callable_manager<_CleanCallable>;
+        using _Manager = detail::_Any_callable_manager<_CleanCallable, Spill>;
         _Manager::store(std::forward<Callable>(callable), any_callable_);
-        any_callable_.operations = &detail::_Operations::create_operations<_CleanCallable>();
+        any_callable_.operations = &detail::_Operations::create_operations<_CleanCallable, Spill>();
         invoker_ = &_Manager::template invoke<R, Args...>;
+#ifdef ACPP_FUNCTION_CAPACITY
+        static_assert(sizeof(detail::_Callable_storage) == detail::_Capacity_current_bytes);
+        detail::_Capacity_record<R(Args...), _CleanCallable, !detail::_In_place_callable<_CleanCallable>>();
+#endif
     }
 
     void unset() {
@@ -186,162 +387,9 @@ private:
 private:
     detail::_Any_callable any_callable_;
     _Callable_invoker invoker_{nullptr};
+#ifdef ACPP_FUNCTION_PROFILE
+    uint32_t profile_site_{detail::_Profile_registry::overflow_site};
+#endif
 };
 
-}
-
-int add(int a, int b) { return a + b; }
-
-template <typename Data>
-struct CustomCallable {
-    Data data;
-    CustomCallable(Data d): data{d} { std::cout << "Ctor for data " << data << std::endl; }
-    CustomCallable(const CustomCallable& oth): data{oth.data} { std::cout << "copy ctor for data " << data << std::endl; }
-    CustomCallable(CustomCallable&& oth) noexcept : data{std::move(oth.data)} { std::cout << "move ctor for data " << data << std::endl; }
-    ~CustomCallable() { std::cout << "Destructor for data " << data << std::endl; }
-    void operator()() const { std::cout << "my data = " << data << std::endl; }
-};
-
-int main() {
-    std::cout << std::alignment_of<acpp::detail::_Callable_storage>::value << std::endl;
-    std::cout << std::alignment_of<CustomCallable<int>>::value << std::endl;
-    std::cout << std::alignment_of<CustomCallable<std::string>>::value << std::endl;
-
-    {
-    std::cout << "\n\n\nPass small lambda by reference\n";
-    int a = 2;
-    auto lambda = [=](int b){ return a + b; };
-    acpp::function<int(int)> f(lambda);
-    std::cout << f(3) << std::endl;
-    }
-
-    {
-    std::cout << "\n\n\nPass small lambda by temporary\n";
-    int a = 2;
-    acpp::function<int(int)> f([=](int b){ return a + b; });
-    std::cout << f(3) << std::endl;
-    }
-
-    {
-    std::cout << "\n\n\nPass small lambda by std::move\n";
-    int a = 2;
-    auto lambda = [=](int b){ return a + b; };
-    acpp::function<int(int)> f(std::move(lambda));
-    std::cout << f(3) << std::endl;
-    }
-
-    {
-    std::cout << "\n\n\nPass large lambda by reference\n";
-    std::string a = "a1";
-    auto lambda = [=](const std::string& b){ return a + b; };
-    acpp::function<std::string(const std::string&)> f(lambda);
-    std::cout << f("b2") << std::endl;
-    }
-
-    {
-    std::cout << "\n\n\nPass large lambda by temporary\n";
-    std::string a = "a1";
-    acpp::function<std::string(const std::string&)> f([=](const std::string& b){ return a + b; });
-    std::cout << f("b2") << std::endl;
-    }
-
-    {
-    std::cout << "\n\n\nPass large lambda by std::move\n";
-    std::string a = "a1";
-    auto lambda = [=](const std::string& b){ return a + b; };
-    acpp::function<std::string(const std::string&)> f(std::move(lambda));
-    std::cout << f("b2") << std::endl;
-    }
-
-    {
-    std::cout << "\n\n\nPass small custom callable by reference\n";
-    CustomCallable<int> c5{42};
-    acpp::function<void()> f5(c5);
-    f5();
-    }
-
-    {
-    std::cout << "\n\n\nPass small custom callable by temporary\n";
-    acpp::function<void()> f5(CustomCallable<int>{42});
-    f5();
-    }
-
-    {
-    std::cout << "\n\n\nPass small custom callable by std::move\n";
-    CustomCallable<int> c5{42};
-    acpp::function<void()> f5(std::move(c5));
-    f5();
-    }
-
-    {
-    std::cout << "\n\n\nPass large custom callable by reference\n";
-    CustomCallable<std::string> c5{"42s"};
-    acpp::function<void()> f5(c5);
-    f5();
-    }
-
-    {
-    std::cout << "\n\n\nPass large custom callable by temporary\n";
-    acpp::function<void()> f5(CustomCallable<std::string>{"42s"});
-    f5();
-    }
-
-    {
-    std::cout << "\n\n\nPass large custom callable by std::move\n";
-    CustomCallable<std::string> c5{"42s"};
-    acpp::function<void()> f5(std::move(c5));
-    f5();
-    }
-
-    /// Copy 
-    {
-    std::cout << "\n\n\ncopy small custom callable\n";
-    CustomCallable<int> c5{42};
-    acpp::function<void()> f1(std::move(c5));
-    acpp::function<void()> f2(f1);
-    f2();
-    }
-
-    {
-    std::cout << "\n\n\nmove small custom callable\n";
-    CustomCallable<int> c5{42};
-    acpp::function<void()> f1(std::move(c5));
-    acpp::function<void()> f2(std::move(f1));
-    f2();
-    }
-
-    // Move
-    {
-    std::cout << "\n\n\ncopy large custom callable\n";
-    CustomCallable<std::string> c5{"42s"};
-    acpp::function<void()> f1(std::move(c5));
-    acpp::function<void()> f2(f1);
-    f2();
-    }
-
-    {
-    std::cout << "\n\n\nmove large custom callable\n";
-    CustomCallable<std::string> c5{"42s"};
-    acpp::function<void()> f1(std::move(c5));
-    acpp::function<void()> f2(std::move(f1));
-    f2();
-    }
-
-    {
-        std::cout << "\n\n\nmove large custom callable\n";
-        acpp::function<void()> f1{[](){std::cout << "Simple lambda output\n";}};
-        acpp::function<void()> f2;
-        f1.swap(f2);
-        f2();
-        // f1();
-    }
-
-    {
-        //
-        // acpp::function<void()> f1{1};
-    }
-
-    std::cout << "End\n";
-
-    return 0;
-}
+} // namespace acpp
@@ -0,0 +1,214 @@
+#pragma once
+
+// Inline-capacity recorder for acpp::function, compiled in with -DACPP_FUNCTION_CAPACITY.
+// Every callable stored into a function (construction or assignment) is counted per signature
+// together with its size, alignment and whether it spilled to the heap. The report gives, per
+// signature, the size and alignment histograms and the smallest inline buffer that keeps a target share of the
+// stores off the heap, with what it would cost per function object.
+// Set ACPP_FUNCTION_CAPACITY_REPORT=<path> to have the report written when the program exits.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "type_name.h"
+
+#ifndef ACPP_FUNCTION_CAPACITY_TARGET
+#define ACPP_FUNCTION_CAPACITY_TARGET 0.95
+#endif
+
+namespace acpp {
+
+/// Stored callables of one signature and the inline buffer they call for
+struct function_capacity_entry {
+    std::string signature;
+    uint64_t stores;
+    uint64_t heap_stores;        // spilled with the current buffer
+    std::map<uint32_t, uint64_t> sizes; // callable size in bytes -> stores
+    std::map<uint32_t, uint64_t> alignments; // alignof(callable) -> stores, every store
+    uint64_t never_inline;       // over-aligned or throwing move: heap at any capacity
+    uint32_t current_bytes;
+    uint32_t recommended_bytes;  // smallest multiple of 8 reaching the target
+    double recommended_inline;   // share of stores inline at recommended_bytes
+    int64_t extra_bytes_per_object;
+};
+
+namespace detail {
+
+// What the buffer can hold: today's size, and the alignment every capacity keeps
+inline constexpr uint32_t _Capacity_current_bytes = 16;
+inline constexpr uint32_t _Capacity_align = 8;
+inline constexpr uint32_t _Capacity_max_bytes = 256;
+
+struct _Capacity_type {
+    std::string_view signature;
+    uint32_t size;
+    uint32_t align;
+    bool nothrow_move;
+    bool spills; // with the current buffer
+};
+
+struct _Capacity_buffer {
+    static constexpr std::size_t max_types = 4096;
+    std::unique_ptr<std::atomic<uint64_t>[]> stores{new std::atomic<uint64_t>[max_types]{}};
+};
+
+class _Capacity_registry {
+public:
+    // Type 0 collects everything past max_types and is left out of reports
+    static constexpr uint32_t overflow_type = 0;
+
+    static _Capacity_registry& instance() {
+        static _Capacity_registry registry;
+        return registry;
+    }
+
+    template <typename Signature, typename Callable, bool Spills>
+    uint32_t type() {
+        std::lock_guard lock(mutex_);
+        if (types_.size() >= _Capacity_buffer::max_types) { return overflow_type; }
+        types_.push_back({_Type_name_v<Signature>, static_cast<uint32_t>(sizeof(Callable)),
+                          static_cast<uint32_t>(alignof(Callable)),
+                          std::is_nothrow_move_constructible<Callable>::value, Spills});
+        return static_cast<uint32_t>(types_.size() - 1);
+    }
+
+    _Capacity_buffer& buffer() {
+        thread_local _Capacity_buffer* local = nullptr;
+        if (!local) [[unlikely]] {
+            // Buffers outlive their thread so exited threads still show up in reports
+            auto buffer = std::make_shared<_Capacity_buffer>();
+            std::lock_guard lock(mutex_);
+            buffers_.push_back(buffer);
+            local = buffer.get();
+        }
+        return *local;
+    }
+
+    std::vector<function_capacity_entry> report(double target) {
+        std::lock_guard lock(mutex_);
+        std::map<std::string_view, function_capacity_entry> by_signature;
+        for (std::size_t id = 1; id < types_.size(); ++id) {
+            uint64_t stores = 0;
+            for (const auto& buffer : buffers_) { stores += buffer->stores[id].load(std::memory_order_relaxed); }
+            if (stores == 0) { continue; }
+            const _Capacity_type& type = types_[id];
+            function_capacity_entry& entry = by_signature[type.signature];
+            entry.stores += stores;
+            if (type.spills) { entry.heap_stores += stores; }
+            entry.alignments[type.align] += stores;
+            if (!type.nothrow_move || type.align > _Capacity_align) {
+                entry.never_inline += stores;
+            } else {
+                entry.sizes[type.size] += stores;
+            }
+        }
+        std::vector<function_capacity_entry> entries;
+        for (auto& [signature, entry] : by_signature) {
+            entry.signature = std::string(signature);
+            recommend(entry, target);
+            entries.push_back(std::move(entry));
+        }
+        std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.stores > b.stores; });
+        return entries;
+    }
+
+    ~_Capacity_registry() {
+        if (const char* path = std::getenv("ACPP_FUNCTION_CAPACITY_REPORT")) {
+            if (std::FILE* out = std::fopen(path, "w")) {
+                write(out, ACPP_FUNCTION_CAPACITY_TARGET);
+                std::fclose(out);
+            }
+        }
+    }
+
+    void write(std::FILE* out, double target) {
+        for (const auto& entry : report(target)) {
+            std::fprintf(out, "%s: %llu stores, %.1f%% on the heap with %u inline bytes\n", entry.signature.c_str(),
+                         static_cast<unsigned long long>(entry.stores), percent(entry.heap_stores, entry.stores),
+                         entry.current_bytes);
+            std::fprintf(out, "  %8s %12s %10s\n", "bytes", "stores", "inline%");
+            uint64_t seen = 0;
+            for (auto [size, stores] : entry.sizes) {
+                seen += stores;
+                std::fprintf(out, "  %8u %12llu %9.1f%%\n", size, static_cast<unsigned long long>(stores),
+                             percent(seen, entry.stores));
+            }
+            std::fprintf(out, "  %8s %12s\n", "align", "stores");
+            for (auto [align, stores] : entry.alignments) {
+                std::fprintf(out, "  %8u %12llu%s\n", align, static_cast<unsigned long long>(stores),
+                             align > _Capacity_align ? "  (over-aligned: heap at any capacity)" : "");
+            }
+            if (entry.never_inline) {
+                std::fprintf(out, "  %8s %12llu  (over-aligned or throwing move)\n", "heap",
+                             static_cast<unsigned long long>(entry.never_inline));
+            }
+            std::fprintf(out, "  recommended: %u inline bytes, %.1f%% inline (target %.1f%%), %+lld bytes per function\n",
+                         entry.recommended_bytes, entry.recommended_inline * 100.0, target * 100.0,
+                         static_cast<long long>(entry.extra_bytes_per_object));
+        }
+    }
+
+private:
+    _Capacity_registry() { types_.push_back({"<other types>", 0, 0, true, false}); }
+
+    static double percent(uint64_t part, uint64_t whole) {
+        return whole ? 100.0 * static_cast<double>(part) / static_cast<double>(whole) : 0.0;
+    }
+
+    // Smallest multiple of the alignment, not below today's size, that keeps target of the
+    // stores inline; when the target can't be met, the size that gets closest
+    static void recommend(function_capacity_entry& entry, double target) {
+        entry.current_bytes = _Capacity_current_bytes;
+        uint32_t bytes = _Capacity_current_bytes;
+        uint64_t fits = 0;
+        for (auto [size, stores] : entry.sizes) {
+            if (size > _Capacity_max_bytes) { break; }
+            if (static_cast<double>(fits) >= target * static_cast<double>(entry.stores)) { break; }
+            fits += stores;
+            bytes = std::max(bytes, (size + _Capacity_align - 1) / _Capacity_align * _Capacity_align);
+        }
+        // Everything at or below the chosen size fits, including what the loop didn't reach
+        fits = 0;
+        for (auto [size, stores] : entry.sizes) {
+            if (size <= bytes) { fits += stores; }
+        }
+        entry.recommended_bytes = bytes;
+        entry.recommended_inline = static_cast<double>(fits) / static_cast<double>(entry.stores);
+        entry.extra_bytes_per_object = static_cast<int64_t>(bytes) - static_cast<int64_t>(_Capacity_current_bytes);
+    }
+
+    std::mutex mutex_;
+    std::vector<_Capacity_type> types_;
+    std::vector<std::shared_ptr<_Capacity_buffer>> buffers_;
+};
+
+// Counts one store of Callable into a function of Signature
+template <typename Signature, typename Callable, bool Spills>
+void _Capacity_record() {
+    static const uint32_t id = _Capacity_registry::instance().type<Signature, Callable, Spills>();
+    std::atomic<uint64_t>& stores = _Capacity_registry::instance().buffer().stores[id];
+    stores.store(stores.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+} // namespace detail
+
+/// Per signature, most stores first, with the buffer size that keeps target of them inline
+inline std::vector<function_capacity_entry> function_capacity(double target = ACPP_FUNCTION_CAPACITY_TARGET) {
+    return detail::_Capacity_registry::instance().report(target);
+}
+
+inline void print_function_capacity(std::FILE* out = stderr, double target = ACPP_FUNCTION_CAPACITY_TARGET) {
+    detail::_Capacity_registry::instance().write(out, target);
+}
+
+} // namespace acpp
@@ -0,0 +1,163 @@
+// Demo of acpp::function construction, copy, move and swap
+// g++ -std=c++20 function_demo.cpp -o function_demo
+
+#include "function.h"
+
+#include <iostream>
+#include <string>
+
+int add(int a, int b) { return a + b; }
+
+template <typename Data>
+struct CustomCallable {
+    Data data;
+    CustomCallable(Data d): data{d} { std::cout << "Ctor for data " << data << std::endl; }
+    CustomCallable(const CustomCallable& oth): data{oth.data} { std::cout << "copy ctor for data " << data << std::endl; }
+    CustomCallable(CustomCallable&& oth) noexcept : data{std::move(oth.data)} { std::cout << "move ctor for data " << data << std::endl; }
+    ~CustomCallable() { std::cout << "Destructor for data " << data << std::endl; }
+    void operator()() const { std::cout << "my data = " << data << std::endl; }
+};
+
+int main() {
+    std::cout << std::alignment_of<acpp::detail::_Callable_storage>::value << std::endl;
+    std::cout << std::alignment_of<CustomCallable<int>>::value << std::endl;
+    std::cout << std::alignment_of<CustomCallable<std::string>>::value << std::endl;
+
+    {
+    std::cout << "\n\n\nPass small lambda by reference\n";
+    int a = 2;
+    auto lambda = [=](int b){ return a + b; };
+    acpp::function<int(int)> f(lambda);
+    std::cout << f(3) << std::endl;
+    }
+
+    {
+    std::cout << "\n\n\nPass small lambda by temporary\n";
+    int a = 2;
+    acpp::function<int(int)> f([=](int b){ return a + b; });
+    std::cout << f(3) << std::endl;
+    }
+
+    {
+    std::cout << "\n\n\nPass small lambda by std::move\n";
+    int a = 2;
+    auto lambda = [=](int b){ return a + b; };
+    acpp::function<int(int)> f(std::move(lambda));
+    std::cout << f(3) << std::endl;
+    }
+
+    {
+    std::cout << "\n\n\nPass large lambda by reference\n";
+    std::string a = "a1";
+    auto lambda = [=](const std::string& b){ return a + b; };
+    acpp::function<std::string(const std::string&)> f(lambda);
+    std::cout << f("b2") << std::endl;
+    }
+
+    {
+    std::cout << "\n\n\nPass large lambda by temporary\n";
+    std::string a = "a1";
+    acpp::function<std::string(const std::string&)> f([=](const std::string& b){ return a + b; });
+    std::cout << f("b2") << std::endl;
+    }
+
+    {
+    std::cout << "\n\n\nPass large lambda by std::move\n";
+    std::string a = "a1";
+    auto lambda = [=](const std::string& b){ return a + b; };
+    acpp::function<std::string(const std::string&)> f(std::move(lambda));
+    std::cout << f("b2") << std::endl;
+    }
+
+    {
+    std::cout << "\n\n\nPass small custom callable by reference\n";
+    CustomCallable<int> c5{42};
+    acpp::function<void()> f5(c5);
+    f5();
+    }
+
+    {
+    std::cout << "\n\n\nPass small custom callable by temporary\n";
+    acpp::function<void()> f5(CustomCallable<int>{42});
+    f5();
+    }
+
+    {
+    std::cout << "\n\n\nPass small custom callable by std::move\n";
+    CustomCallable<int> c5{42};
+    acpp::function<void()> f5(std::move(c5));
+    f5();
+    }
+
+    {
+    std::cout << "\n\n\nPass large custom callable by reference\n";
+    CustomCallable<std::string> c5{"42s"};
+    acpp::function<void()> f5(c5);
+    f5();
+    }
+
+    {
+    std::cout << "\n\n\nPass large custom callable by temporary\n";
+    acpp::function<void()> f5(CustomCallable<std::string>{"42s"});
+    f5();
+    }
+
+    {
+    std::cout << "\n\n\nPass large custom callable by std::move\n";
+    CustomCallable<std::string> c5{"42s"};
+    acpp::function<void()> f5(std::move(c5));
+    f5();
+    }
+
+    /// Copy 
+    {
+    std::cout << "\n\n\ncopy small custom callable\n";
+    CustomCallable<int> c5{42};
+    acpp::function<void()> f1(std::move(c5));
+    acpp::function<void()> f2(f1);
+    f2();
+    }
+
+    {
+    std::cout << "\n\n\nmove small custom callable\n";
+    CustomCallable<int> c5{42};
+    acpp::function<void()> f1(std::move(c5));
+    acpp::function<void()> f2(std::move(f1));
+    f2();
+    }
+
+    // Move
+    {
+    std::cout << "\n\n\ncopy large custom callable\n";
+    CustomCallable<std::string> c5{"42s"};
+    acpp::function<void()> f1(std::move(c5));
+    acpp::function<void()> f2(f1);
+    f2();
+    }
+
+    {
+    std::cout << "\n\n\nmove large custom callable\n";
+    CustomCallable<std::string> c5{"42s"};
+    acpp::function<void()> f1(std::move(c5));
+    acpp::function<void()> f2(std::move(f1));
+    f2();
+    }
+
+    {
+        std::cout << "\n\n\nmove large custom callable\n";
+        acpp::function<void()> f1{[](){std::cout << "Simple lambda output\n";}};
+        acpp::function<void()> f2;
+        f1.swap(f2);
+        f2();
+        // f1();
+    }
+
+    {
+        //
+        // acpp::function<void()> f1{1};
+    }
+
+    std::cout << "End\n";
+
+    return 0;
+}
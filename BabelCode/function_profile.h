@@ -0,0 +1,239 @@
+#pragma once
+
+// Per-call-site invocation profiler for acpp::function, compiled in with -DACPP_FUNCTION_PROFILE.
+// Every function remembers the site it was built at (callable type + source location of the
+// construction). operator() counts calls per site in a per-thread buffer and times one call in
+// ACPP_FUNCTION_PROFILE_SAMPLE with the cycle counter. function_profile() merges the buffers.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "type_name.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef ACPP_FUNCTION_PROFILE_SAMPLE
+#define ACPP_FUNCTION_PROFILE_SAMPLE 16
+#endif
+
+namespace acpp {
+
+/// One call site in a profile report
+struct function_profile_entry {
+    std::string callable;
+    std::string file;
+    std::string function;
+    uint32_t line;
+    uint32_t column;
+    uint64_t calls;
+    double total_ns; // extrapolated from the sampled calls
+    double mean_ns;
+};
+
+namespace detail {
+
+inline uint64_t _Profile_ticks() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Counters of one site in one thread. Only the owning thread writes, so plain
+// load + store is enough; the atomics let the report read them while it runs.
+// The sampling countdown is per site, a shared one would alias with regular call patterns.
+struct _Site_counters {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> ticks{0};
+    uint32_t countdown{0};
+};
+
+struct _Profile_buffer {
+    static constexpr std::size_t max_sites = 4096;
+    std::unique_ptr<_Site_counters[]> sites{new _Site_counters[max_sites]};
+};
+
+class _Profile_registry {
+public:
+    // Site 0 collects everything past max_sites
+    static constexpr uint32_t overflow_site = 0;
+
+    static _Profile_registry& instance() {
+        static _Profile_registry registry;
+        return registry;
+    }
+
+    // Cached per thread and callable type for the last few locations it was built at, so the
+    // lock and the map lookup are taken once per site rather than on every construction
+    template <typename Callable>
+    uint32_t site(const std::source_location& location) {
+        struct _Cached {
+            const char* file;
+            uint32_t line;
+            uint32_t column;
+            uint32_t id;
+        };
+        thread_local _Cached cache[4]{};
+        thread_local uint32_t next = 0;
+        for (const _Cached& entry : cache) {
+            if (entry.file == location.file_name() && entry.line == location.line() && entry.column == location.column()) {
+                return entry.id;
+            }
+        }
+        uint32_t id = lookup<Callable>(location);
+        cache[next++ % 4] = {location.file_name(), location.line(), location.column(), id};
+        return id;
+    }
+
+    _Profile_buffer& buffer() {
+        thread_local _Profile_buffer* local = nullptr;
+        if (!local) [[unlikely]] {
+            // Buffers outlive their thread so exited threads still show up in reports
+            auto buffer = std::make_shared<_Profile_buffer>();
+            std::lock_guard lock(mutex_);
+            buffers_.push_back(buffer);
+            local = buffer.get();
+        }
+        return *local;
+    }
+
+    std::vector<function_profile_entry> report(std::size_t top_n) {
+        double ticks_per_ns = calibrate();
+        uint64_t overhead = timer_overhead();
+        std::lock_guard lock(mutex_);
+        std::vector<function_profile_entry> entries;
+        for (std::size_t id = 0; id < sites_.size(); ++id) {
+            uint64_t calls = 0, samples = 0, ticks = 0;
+            for (const auto& buffer : buffers_) {
+                calls += buffer->sites[id].calls.load(std::memory_order_relaxed);
+                samples += buffer->sites[id].samples.load(std::memory_order_relaxed);
+                ticks += buffer->sites[id].ticks.load(std::memory_order_relaxed);
+            }
+            if (calls == 0) { continue; }
+            ticks = ticks > samples * overhead ? ticks - samples * overhead : 0;
+            double mean_ns = samples ? static_cast<double>(ticks) / ticks_per_ns / static_cast<double>(samples) : 0.0;
+            const _Site_info& info = sites_[id];
+            entries.push_back({std::string(info.type), info.file, info.function, info.line, info.column,
+                               calls, mean_ns * static_cast<double>(calls), mean_ns});
+        }
+        std::sort(entries.begin(), entries.end(),
+                  [](const auto& a, const auto& b) { return a.total_ns > b.total_ns; });
+        if (entries.size() > top_n) { entries.resize(top_n); }
+        return entries;
+    }
+
+private:
+    struct _Site_info {
+        std::string_view type;
+        const char* file;
+        const char* function;
+        uint32_t line;
+        uint32_t column;
+    };
+
+    template <typename Callable>
+    uint32_t lookup(const std::source_location& location) {
+        std::string_view type = _Type_name_v<Callable>;
+        std::lock_guard lock(mutex_);
+        auto key = std::make_tuple(type.data(), location.file_name(), location.line(), location.column());
+        auto [it, inserted] = ids_.try_emplace(key, static_cast<uint32_t>(sites_.size()));
+        if (inserted) {
+            if (sites_.size() >= _Profile_buffer::max_sites) {
+                it->second = overflow_site;
+            } else {
+                sites_.push_back({type, location.file_name(), location.function_name(), location.line(), location.column()});
+            }
+        }
+        return it->second;
+    }
+
+    _Profile_registry()
+        : start_ticks_{_Profile_ticks()}, start_time_{std::chrono::steady_clock::now()} {
+        sites_.push_back({"<other sites>", "", "", 0, 0});
+    }
+
+    // Ticks per nanosecond measured since the registry was created
+    double calibrate() const {
+        while (std::chrono::steady_clock::now() - start_time_ < std::chrono::milliseconds(10)) {}
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time_).count();
+        return static_cast<double>(_Profile_ticks() - start_ticks_) / ns;
+    }
+
+    // Cost of two back-to-back reads, taken out of every sample
+    static uint64_t timer_overhead() noexcept {
+        uint64_t best = UINT64_MAX;
+        for (int i = 0; i < 1000; ++i) {
+            uint64_t start = _Profile_ticks();
+            best = std::min(best, _Profile_ticks() - start);
+        }
+        return best;
+    }
+
+    std::mutex mutex_;
+    std::map<std::tuple<const char*, const char*, uint32_t, uint32_t>, uint32_t> ids_;
+    std::vector<_Site_info> sites_;
+    std::vector<std::shared_ptr<_Profile_buffer>> buffers_;
+    uint64_t start_ticks_;
+    std::chrono::steady_clock::time_point start_time_;
+};
+
+// Wraps one call: counts it, and times it when the site's countdown hits zero
+class _Profile_scope {
+public:
+    explicit _Profile_scope(uint32_t site) {
+        counters_ = &_Profile_registry::instance().buffer().sites[site];
+        counters_->calls.store(counters_->calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (counters_->countdown-- == 0) {
+            counters_->countdown = ACPP_FUNCTION_PROFILE_SAMPLE - 1;
+            start_ = _Profile_ticks();
+        }
+    }
+
+    _Profile_scope(const _Profile_scope&) = delete;
+    _Profile_scope& operator=(const _Profile_scope&) = delete;
+
+    ~_Profile_scope() {
+        if (start_ == 0) { return; }
+        uint64_t elapsed = _Profile_ticks() - start_;
+        counters_->samples.store(counters_->samples.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        counters_->ticks.store(counters_->ticks.load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+    }
+
+private:
+    _Site_counters* counters_;
+    uint64_t start_{0};
+};
+
+} // namespace detail
+
+/// Top-N call sites by estimated total time, over all threads
+inline std::vector<function_profile_entry> function_profile(std::size_t top_n = 20) {
+    return detail::_Profile_registry::instance().report(top_n);
+}
+
+inline void print_function_profile(std::FILE* out = stderr, std::size_t top_n = 20) {
+    std::fprintf(out, "%12s %12s %10s  %s\n", "calls", "total ms", "mean ns", "site");
+    for (const auto& entry : function_profile(top_n)) {
+        std::fprintf(out, "%12llu %12.3f %10.1f  %s:%u:%u (%s) %s\n",
+                     static_cast<unsigned long long>(entry.calls), entry.total_ns / 1e6, entry.mean_ns,
+                     entry.file.c_str(), entry.line, entry.column, entry.function.c_str(), entry.callable.c_str());
+    }
+}
+
+} // namespace acpp
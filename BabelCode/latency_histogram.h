@@ -0,0 +1,218 @@
+#pragma once
+
+// Log-bucketed (HDR style) latency histograms, recorded per thread and merged on read.
+// Values are nanoseconds. Below 64 every value has its own bucket; above, each power of two
+// is split in 32 linear sub-buckets, so any reported value is within ~3% of the recorded one.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+namespace acpp {
+namespace detail {
+
+inline uint64_t _Latency_clock_ns() noexcept {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+inline constexpr uint32_t _Latency_max_threads = 64;
+
+// Bit i set: own slot i is held by a live thread. The last slot is the shared one and is
+// never handed out, so it stays set.
+inline std::atomic<uint64_t> _Latency_slots_taken{uint64_t{1} << (_Latency_max_threads - 1)};
+
+// A thread's slot: the lowest free own slot, or the shared one when all are held. Given back
+// when the thread exits, so threads that come and go don't use up the own slots; the release
+// and the next owner's acquire order the old owner's plain stores before the new owner's.
+struct _Latency_slot {
+    uint32_t index;
+
+    _Latency_slot() noexcept {
+        uint64_t taken = _Latency_slots_taken.load(std::memory_order_relaxed);
+        do {
+            index = static_cast<uint32_t>(std::countr_one(taken));
+            if (index >= _Latency_max_threads - 1) { return; }
+        } while (!_Latency_slots_taken.compare_exchange_weak(taken, taken | (uint64_t{1} << index),
+                                                             std::memory_order_acquire, std::memory_order_relaxed));
+    }
+
+    ~_Latency_slot() {
+        if (index < _Latency_max_threads - 1) {
+            _Latency_slots_taken.fetch_and(~(uint64_t{1} << index), std::memory_order_release);
+        }
+    }
+};
+
+inline uint32_t _Latency_thread_slot() noexcept {
+    thread_local _Latency_slot slot;
+    return slot.index;
+}
+
+struct _Latency_buckets {
+    static constexpr uint32_t sub_bits = 5;
+    static constexpr uint32_t linear = 2u << sub_bits;  // values with their own bucket
+    static constexpr uint32_t half = 1u << sub_bits;    // sub-buckets per power of two
+    static constexpr uint32_t count = linear + (64 - sub_bits - 1) * half;
+
+    static constexpr uint32_t index(uint64_t value) noexcept {
+        if (value < linear) { return static_cast<uint32_t>(value); }
+        uint32_t shift = static_cast<uint32_t>(std::bit_width(value)) - sub_bits - 1;
+        return linear + (shift - 1) * half + static_cast<uint32_t>((value >> shift) - half);
+    }
+
+    // Largest value that lands in bucket i
+    static constexpr uint64_t upper(uint32_t i) noexcept {
+        if (i < linear) { return i; }
+        uint32_t shift = (i - linear) / half + 1;
+        uint64_t sub = (i - linear) % half + half;
+        return ((sub + 1) << shift) - 1;
+    }
+};
+
+// One thread's counts. Written only by the owning thread with plain load + store,
+// read concurrently by snapshot().
+struct _Latency_shard {
+    std::array<std::atomic<uint64_t>, _Latency_buckets::count> buckets{};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> max{0};
+
+    static void bump(std::atomic<uint64_t>& counter, uint64_t delta) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+};
+
+} // namespace detail
+
+/// Merged, read-only view of a latency_histogram
+class latency_snapshot {
+public:
+    uint64_t count() const noexcept { return samples_; }
+    uint64_t max() const noexcept { return max_; }
+    double mean() const noexcept { return samples_ ? static_cast<double>(sum_) / static_cast<double>(samples_) : 0.0; }
+
+    /// Value at quantile q in [0, 1], e.g. 0.999 for p99.9
+    uint64_t percentile(double q) const noexcept {
+        if (samples_ == 0) { return 0; }
+        auto rank = static_cast<uint64_t>(q * static_cast<double>(samples_ - 1)) + 1;
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < detail::_Latency_buckets::count; ++i) {
+            seen += buckets_[i];
+            if (seen >= rank) { return std::min(detail::_Latency_buckets::upper(i), max_); }
+        }
+        return max_;
+    }
+
+    /// Summary line plus one line per non-empty bucket: "<= upper_ns count cumulative_fraction"
+    std::string to_text(const char* name) const {
+        std::string text;
+        char line[160];
+        std::snprintf(line, sizeof(line),
+                      "%s count=%llu mean=%.1fns p50=%llu p90=%llu p99=%llu p99.9=%llu max=%llu\n", name,
+                      static_cast<unsigned long long>(samples_), mean(),
+                      static_cast<unsigned long long>(percentile(0.5)), static_cast<unsigned long long>(percentile(0.9)),
+                      static_cast<unsigned long long>(percentile(0.99)), static_cast<unsigned long long>(percentile(0.999)),
+                      static_cast<unsigned long long>(max_));
+        text += line;
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < detail::_Latency_buckets::count; ++i) {
+            if (buckets_[i] == 0) { continue; }
+            seen += buckets_[i];
+            std::snprintf(line, sizeof(line), "  <= %llu %llu %.6f\n",
+                          static_cast<unsigned long long>(detail::_Latency_buckets::upper(i)),
+                          static_cast<unsigned long long>(buckets_[i]),
+                          static_cast<double>(seen) / static_cast<double>(samples_));
+            text += line;
+        }
+        return text;
+    }
+
+private:
+    friend class latency_histogram;
+
+    std::array<uint64_t, detail::_Latency_buckets::count> buckets_{};
+    uint64_t samples_{0};
+    uint64_t sum_{0};
+    uint64_t max_{0};
+};
+
+/// Latency histogram safe to record into from any thread. Up to max_threads - 1 live threads
+/// get a shard of their own and record with plain loads and stores; further ones share the
+/// last shard through atomic adds. A shard passes to another thread once its owner exits.
+class latency_histogram {
+public:
+    static constexpr uint32_t max_threads = detail::_Latency_max_threads;
+
+    latency_histogram() = default;
+    latency_histogram(const latency_histogram&) = delete;
+    latency_histogram& operator=(const latency_histogram&) = delete;
+
+    ~latency_histogram() {
+        for (auto& shard : shards_) { delete shard.load(std::memory_order_relaxed); }
+    }
+
+    void record(uint64_t ns) {
+        uint32_t slot = detail::_Latency_thread_slot();
+        detail::_Latency_shard& shard = this->shard(slot < max_threads - 1 ? slot : max_threads - 1);
+        uint32_t i = detail::_Latency_buckets::index(ns);
+        if (slot < max_threads - 1) [[likely]] {
+            detail::_Latency_shard::bump(shard.buckets[i], 1);
+            detail::_Latency_shard::bump(shard.sum, ns);
+            if (ns > shard.max.load(std::memory_order_relaxed)) { shard.max.store(ns, std::memory_order_relaxed); }
+        } else {
+            shard.buckets[i].fetch_add(1, std::memory_order_relaxed);
+            shard.sum.fetch_add(ns, std::memory_order_relaxed);
+            uint64_t max = shard.max.load(std::memory_order_relaxed);
+            while (ns > max && !shard.max.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+        }
+    }
+
+    /// Merges the shards. Samples recorded concurrently may or may not be included.
+    latency_snapshot snapshot() const {
+        latency_snapshot merged;
+        for (const auto& slot : shards_) {
+            const detail::_Latency_shard* shard = slot.load(std::memory_order_acquire);
+            if (!shard) { continue; }
+            for (uint32_t i = 0; i < detail::_Latency_buckets::count; ++i) {
+                merged.buckets_[i] += shard->buckets[i].load(std::memory_order_relaxed);
+            }
+            merged.sum_ += shard->sum.load(std::memory_order_relaxed);
+            merged.max_ = std::max(merged.max_, shard->max.load(std::memory_order_relaxed));
+        }
+        // Counted from the buckets so the totals agree with what percentile() walks
+        for (uint64_t count : merged.buckets_) { merged.samples_ += count; }
+        return merged;
+    }
+
+private:
+    detail::_Latency_shard& shard(uint32_t slot) {
+        detail::_Latency_shard* shard = shards_[slot].load(std::memory_order_acquire);
+        if (!shard) [[unlikely]] {
+            auto fresh = std::make_unique<detail::_Latency_shard>();
+            if (shards_[slot].compare_exchange_strong(shard, fresh.get(), std::memory_order_acq_rel)) {
+                shard = fresh.release();
+            }
+        }
+        return *shard;
+    }
+
+    std::array<std::atomic<detail::_Latency_shard*>, max_threads> shards_{};
+};
+
+/// Queue delay (enqueue to start) and run time of the tasks of one executor or queue
+struct task_latency {
+    latency_histogram queue_delay;
+    latency_histogram run_time;
+
+    std::string to_text() const {
+        return queue_delay.snapshot().to_text("queue_delay_ns") + run_time.snapshot().to_text("run_time_ns");
+    }
+};
+
+} // namespace acpp
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "function.h"
+
+namespace acpp {
+namespace detail {
+
+inline void _Futex_wait(std::atomic<uint32_t>& word, uint32_t expected) noexcept {
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+inline void _Futex_wake_all(std::atomic<uint32_t>& word) noexcept {
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+} // namespace detail
+
+/// One-shot flag driven by a single 32-bit state word.
+/// Done is checked with one acquire load; concurrent first callers sleep on a futex.
+class once_flag {
+public:
+    constexpr once_flag() noexcept = default;
+    once_flag(const once_flag&) = delete;
+    once_flag& operator=(const once_flag&) = delete;
+
+    bool is_done() const noexcept { return state_.load(std::memory_order_acquire) == _Done; }
+
+private:
+    template <typename Callable>
+    friend void call_once(once_flag& flag, Callable&& callable);
+
+    enum : uint32_t { _Idle = 0, _Running = 1, _Running_with_waiters = 2, _Done = 3 };
+
+    // Returns true when the caller won the right to run the initializer
+    bool begin() noexcept {
+        uint32_t state = state_.load(std::memory_order_acquire);
+        while (true) {
+            if (state == _Done) { return false; }
+            if (state == _Idle) {
+                if (state_.compare_exchange_weak(state, _Running, std::memory_order_acquire)) { return true; }
+                continue;
+            }
+            if (state == _Running &&
+                !state_.compare_exchange_weak(state, _Running_with_waiters, std::memory_order_acquire)) {
+                continue;
+            }
+            detail::_Futex_wait(state_, _Running_with_waiters);
+            state = state_.load(std::memory_order_acquire);
+        }
+    }
+
+    void finish(uint32_t next) noexcept {
+        if (state_.exchange(next, std::memory_order_release) == _Running_with_waiters) {
+            detail::_Futex_wake_all(state_);
+        }
+    }
+
+    std::atomic<uint32_t> state_{_Idle};
+};
+
+/// Runs callable exactly once per flag. If it throws the flag stays unset and one
+/// of the waiting callers retries, like std::call_once.
+template <typename Callable>
+void call_once(once_flag& flag, Callable&& callable) {
+    if (flag.is_done()) [[likely]] { return; }
+    if (!flag.begin()) { return; }
+    try {
+        std::forward<Callable>(callable)();
+    } catch (...) {
+        flag.finish(once_flag::_Idle);
+        throw;
+    }
+    flag.finish(once_flag::_Done);
+}
+
+/// Value computed on first access by an initializer stored inline in an acpp::function.
+/// The initializer, and whatever it captured, is destroyed as soon as the value exists.
+/// After that get() is one acquire load (a plain load on x86) and a predictable branch.
+template <typename T>
+class lazy {
+public:
+    template <typename Callable> requires _Is_valid_callable<Callable, T>
+    explicit lazy(Callable&& initializer) {
+        new (&init_) function<T()>(std::forward<Callable>(initializer));
+    }
+
+    lazy(const lazy&) = delete;
+    lazy& operator=(const lazy&) = delete;
+
+    ~lazy() {
+        if (flag_.is_done()) {
+            value_.~T();
+        } else {
+            init_.~basic_function();
+        }
+    }
+
+    const T& get() const {
+        if (!flag_.is_done()) [[unlikely]] { initialize(); }
+        return value_;
+    }
+
+    T& get() {
+        if (!flag_.is_done()) [[unlikely]] { initialize(); }
+        return value_;
+    }
+
+    const T& operator*() const { return get(); }
+    T& operator*() { return get(); }
+    const T* operator->() const { return &get(); }
+    T* operator->() { return &get(); }
+
+    bool is_initialized() const noexcept { return flag_.is_done(); }
+
+private:
+    void initialize() const {
+        call_once(flag_, [this] {
+            new (&value_) T(init_());
+            // The value lives in its own member, so the initializer can go right away
+            init_.~basic_function();
+        });
+    }
+
+    mutable once_flag flag_;
+    union {
+        mutable function<T()> init_;
+    };
+    union {
+        mutable T value_;
+    };
+};
+
+} // namespace acpp
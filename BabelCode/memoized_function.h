@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "function.h"
+
+namespace acpp {
+namespace detail {
+
+inline std::size_t _Hash_mix(std::size_t seed, std::size_t hash) noexcept {
+    return seed ^ (hash + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+template <typename... Keys>
+std::size_t _Hash_args(const std::tuple<Keys...>& key) noexcept {
+    return std::apply([](const auto&... parts) {
+        std::size_t seed = sizeof...(Keys);
+        ((seed = _Hash_mix(seed, std::hash<std::decay_t<decltype(parts)>>{}(parts))), ...);
+        // Final avalanche so the low bits pick shards and buckets evenly
+        seed ^= seed >> 33;
+        seed *= 0xff51afd7ed558ccdull;
+        seed ^= seed >> 33;
+        return seed;
+    }, key);
+}
+
+// Fixed-capacity cache shard with CLOCK eviction. Entries sit in a flat array swept by the
+// clock hand; a linear-probing index twice the capacity maps hashes to entries, and is
+// repaired with backward shifting on eviction, so there are no tombstones and no allocations
+// once the shard is full.
+template <typename Key, typename Value>
+class _Clock_shard {
+public:
+    explicit _Clock_shard(std::size_t capacity)
+        : entries_(capacity), index_(std::bit_ceil(capacity * 2), _Empty), index_mask_{index_.size() - 1} {}
+
+    std::optional<Value> find(const Key& key, std::size_t hash) {
+        std::lock_guard lock(mutex_);
+        for (std::size_t i = _Bucket(hash);; i = (i + 1) & index_mask_) {
+            uint32_t slot = index_[i];
+            if (slot == _Empty) { ++misses_; return std::nullopt; }
+            _Entry& entry = entries_[slot];
+            if (entry.hash == hash && *entry.key == key) {
+                entry.referenced = true;
+                ++hits_;
+                return *entry.value;
+            }
+        }
+    }
+
+    void insert(Key key, std::size_t hash, const Value& value) {
+        std::lock_guard lock(mutex_);
+        std::size_t i = _Bucket(hash);
+        for (; index_[i] != _Empty; i = (i + 1) & index_mask_) {
+            const _Entry& entry = entries_[index_[i]];
+            // Another thread computed it meanwhile
+            if (entry.hash == hash && *entry.key == key) { return; }
+        }
+        uint32_t slot;
+        if (used_ < entries_.size()) {
+            slot = static_cast<uint32_t>(used_++);
+        } else {
+            slot = evict();
+            // Eviction may have shifted our probe chain, find the free bucket again
+            for (i = _Bucket(hash); index_[i] != _Empty; i = (i + 1) & index_mask_) {}
+        }
+        _Entry& entry = entries_[slot];
+        entry.key.emplace(std::move(key));
+        entry.value.emplace(value);
+        entry.hash = hash;
+        entry.bucket = static_cast<uint32_t>(i);
+        entry.referenced = false;
+        index_[i] = slot;
+    }
+
+    void clear() {
+        std::lock_guard lock(mutex_);
+        for (auto& entry : entries_) { entry.key.reset(); entry.value.reset(); }
+        std::fill(index_.begin(), index_.end(), _Empty);
+        used_ = 0;
+        hand_ = 0;
+    }
+
+    void add_stats(uint64_t& hits, uint64_t& misses, uint64_t& evictions, std::size_t& size) const {
+        std::lock_guard lock(mutex_);
+        hits += hits_;
+        misses += misses_;
+        evictions += evictions_;
+        size += used_;
+    }
+
+private:
+    static constexpr uint32_t _Empty = ~uint32_t{0};
+
+    struct _Entry {
+        std::optional<Key> key;
+        std::optional<Value> value;
+        std::size_t hash{0};
+        uint32_t bucket{0};
+        bool referenced{false};
+    };
+
+    std::size_t _Bucket(std::size_t hash) const noexcept { return (hash >> 16) & index_mask_; }
+
+    // Second-chance sweep: clear reference bits until an unreferenced entry shows up
+    uint32_t evict() {
+        while (true) {
+            _Entry& entry = entries_[hand_];
+            uint32_t slot = static_cast<uint32_t>(hand_);
+            hand_ = hand_ + 1 == entries_.size() ? 0 : hand_ + 1;
+            if (entry.referenced) {
+                entry.referenced = false;
+                continue;
+            }
+            unlink(entry.bucket);
+            entry.key.reset();
+            entry.value.reset();
+            ++evictions_;
+            return slot;
+        }
+    }
+
+    // Backward-shift deletion keeps every probe chain contiguous
+    void unlink(std::size_t hole) {
+        index_[hole] = _Empty;
+        for (std::size_t i = (hole + 1) & index_mask_; index_[i] != _Empty; i = (i + 1) & index_mask_) {
+            _Entry& entry = entries_[index_[i]];
+            std::size_t home = _Bucket(entry.hash);
+            // Move it back if the hole lies between its home bucket and where it sits now
+            if (((i - home) & index_mask_) >= ((i - hole) & index_mask_)) {
+                index_[hole] = index_[i];
+                entry.bucket = static_cast<uint32_t>(hole);
+                index_[i] = _Empty;
+                hole = i;
+            }
+        }
+    }
+
+    alignas(64) mutable std::mutex mutex_;
+    std::vector<_Entry> entries_;
+    std::vector<uint32_t> index_;
+    std::size_t index_mask_;
+    std::size_t used_{0};
+    std::size_t hand_{0};
+    uint64_t hits_{0};
+    uint64_t misses_{0};
+    uint64_t evictions_{0};
+};
+
+} // namespace detail
+
+template <typename... Args>
+class memoized_function;
+
+/// Wraps a pure callable and caches its results keyed by the (decayed) arguments.
+/// The cache is bounded and split into independently locked shards picked by the argument
+/// hash; each shard evicts with CLOCK. The callable runs outside any lock, so two threads
+/// missing on the same key may both compute it; the first result stored wins.
+template <typename R, typename... Args>
+class memoized_function<R(Args...)> {
+private:
+    using _Key = std::tuple<std::decay_t<Args>...>;
+    using _Shard = detail::_Clock_shard<_Key, R>;
+
+public:
+    struct stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        uint64_t evictions{0};
+        std::size_t size{0};
+    };
+
+    template <typename Callable> requires _Is_valid_callable<Callable, R, Args...>
+    explicit memoized_function(Callable&& callable, std::size_t capacity = 4096, std::size_t shards = 16)
+        : fn_{std::forward<Callable>(callable)} {
+        shards = std::bit_ceil(shards ? shards : 1);
+        std::size_t per_shard = (capacity + shards - 1) / shards;
+        shards_.reserve(shards);
+        for (std::size_t i = 0; i < shards; ++i) {
+            shards_.push_back(std::make_unique<_Shard>(per_shard ? per_shard : 1));
+        }
+        shard_mask_ = shards - 1;
+    }
+
+    R operator()(Args... args) const {
+        _Key key{args...};
+        std::size_t hash = detail::_Hash_args(key);
+        _Shard& shard = *shards_[hash & shard_mask_];
+        if (auto cached = shard.find(key, hash)) { return std::move(*cached); }
+        R result = fn_(std::forward<Args>(args)...);
+        shard.insert(std::move(key), hash, result);
+        return result;
+    }
+
+    stats statistics() const {
+        stats s;
+        for (const auto& shard : shards_) { shard->add_stats(s.hits, s.misses, s.evictions, s.size); }
+        return s;
+    }
+
+    void clear() {
+        for (auto& shard : shards_) { shard->clear(); }
+    }
+
+private:
+    mutable function<R(Args...)> fn_;
+    std::vector<std::unique_ptr<_Shard>> shards_;
+    std::size_t shard_mask_{0};
+};
+
+} // namespace acpp
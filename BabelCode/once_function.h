@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "function.h"
+
+namespace acpp {
+namespace detail {
+
+// Invokes the stored callable as an rvalue and destroys it before returning, heap spill included
+template <typename Callable, typename R, typename... Args>
+R _Invoke_once(_Any_callable& any_callable, Args... args) {
+    using _Manager = _Any_callable_manager<Callable>;
+    struct _Destroy_guard {
+        _Any_callable& any_callable;
+        ~_Destroy_guard() { _Manager::destroy(any_callable); }
+    } guard{any_callable};
+    return std::move(_Manager::get_ref(any_callable))(std::forward<Args>(args)...);
+}
+
+} // namespace detail
+
+template <typename... Args>
+class once_function;
+
+template <typename Callable, typename R, typename... Args>
+concept _Is_valid_once_callable =
+    std::same_as<std::invoke_result_t<std::decay_t<Callable>&&, Args...>, R> &&
+    !std::is_same_v<std::remove_cvref_t<Callable>, once_function<R(Args...)>>;
+
+/// Move-only function that can be called once, as an rvalue: std::move(f)(args...).
+/// The call empties the wrapper and destroys the callable (freeing a heap spill) before it
+/// returns, so captured state doesn't outlive the call the way it does with function.
+template <typename R, typename... Args>
+class once_function<R(Args...)> {
+private:
+    using _Callable_invoker = R (*)(detail::_Any_callable&, Args...);
+
+public:
+    once_function() noexcept = default;
+    once_function(const once_function&) = delete;
+    once_function(once_function&& oth) noexcept {
+        if (oth) {
+            oth.operations_->move(any_callable_, oth.any_callable_);
+            operations_ = std::exchange(oth.operations_, nullptr);
+            invoker_ = std::exchange(oth.invoker_, nullptr);
+        }
+    }
+    once_function& operator=(once_function oth) noexcept { swap(oth); return *this; }
+
+    template <typename Callable> requires _Is_valid_once_callable<Callable, R, Args...>
+    once_function(Callable&& callable) { set(std::forward<Callable>(callable)); }
+
+    ~once_function() { if (*this) { unset(); } }
+
+    R operator()(Args... args) && {
+        if (!operations_) {
+            throw std::runtime_error("bad once_function call");
+        }
+        // Empty before the call, so the wrapper is empty even if the callable throws
+        operations_ = nullptr;
+        return (*std::exchange(invoker_, nullptr))(any_callable_, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const noexcept { return operations_ != nullptr; }
+
+    void swap(once_function& oth) noexcept {
+        detail::_Any_callable temp_callable;
+        if (oth) { oth.operations_->move(temp_callable, oth.any_callable_); }
+        if (*this) { operations_->move(oth.any_callable_, any_callable_); }
+        if (oth) { oth.operations_->move(any_callable_, temp_callable); }
+        std::swap(operations_, oth.operations_);
+        std::swap(invoker_, oth.invoker_);
+    }
+
+private:
+    template <typename Callable>
+    void set(Callable&& callable) {
+        using _CleanCallable = std::decay_t<Callable>;
+        detail::_Any_callable_manager<_CleanCallable>::store(std::forward<Callable>(callable), any_callable_);
+        operations_ = &detail::_Operations::create_move_only_operations<_CleanCallable>();
+        invoker_ = &detail::_Invoke_once<_CleanCallable, R, Args...>;
+    }
+
+    void unset() {
+        operations_->destroy(any_callable_);
+        operations_ = nullptr;
+        invoker_ = nullptr;
+    }
+
+private:
+    // any_callable_.operations stays null, the vtable (copy is null) lives in operations_
+    detail::_Any_callable any_callable_;
+    const detail::_Operations* operations_{nullptr};
+    _Callable_invoker invoker_{nullptr};
+};
+
+} // namespace acpp
@@ -0,0 +1,138 @@
+// Interposers behind acpp::rt_scope. Link this file into checking builds (-DACPP_RT_CHECK);
+// it replaces operator new/delete, the malloc family and pthread_mutex_lock for the whole
+// program and forwards to glibc after checking for an active scope on the calling thread.
+
+#ifndef ACPP_RT_CHECK
+#define ACPP_RT_CHECK
+#endif
+#include "rt_scope.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <unistd.h>
+
+extern "C" {
+void* __libc_malloc(std::size_t);
+void* __libc_calloc(std::size_t, std::size_t);
+void* __libc_realloc(void*, std::size_t);
+void* __libc_memalign(std::size_t, std::size_t);
+void __libc_free(void*);
+}
+
+namespace acpp::detail {
+
+void _Rt_report(rt_violation_kind kind, std::size_t bytes) noexcept {
+    _Rt_current.reporting = true;
+    _Rt_violations.fetch_add(1, std::memory_order_relaxed);
+    static constexpr const char* kinds[] = {"allocation", "deallocation", "lock"};
+    char line[512];
+    int length = std::snprintf(line, sizeof(line), "acpp::rt_scope: %s", kinds[static_cast<int>(kind)]);
+    if (kind == rt_violation_kind::allocation) {
+        length += std::snprintf(line + length, sizeof(line) - length, " of %zu bytes", bytes);
+    }
+    length += std::snprintf(line + length, sizeof(line) - length, " in '%s' (%s:%u)", _Rt_current.scope,
+                            _Rt_current.file, _Rt_current.line);
+    if (_Rt_current.callable) {
+        length += std::snprintf(line + length, sizeof(line) - length, " while in callable '%.*s'",
+                                static_cast<int>(_Rt_current.callable_length), _Rt_current.callable);
+    }
+    if (length > static_cast<int>(sizeof(line)) - 2) { length = sizeof(line) - 2; }
+    line[length++] = '\n';
+    (void)!::write(STDERR_FILENO, line, static_cast<std::size_t>(length));
+    if (_Rt_policy.load(std::memory_order_relaxed) == rt_violation_policy::abort) { std::abort(); }
+    _Rt_current.reporting = false;
+}
+
+inline void _Rt_check(rt_violation_kind kind, std::size_t bytes = 0) noexcept {
+    if (_Rt_active()) [[unlikely]] { _Rt_report(kind, bytes); }
+}
+
+using _Mutex_lock = int (*)(pthread_mutex_t*);
+
+// Resolved before main so the lookup (which may allocate) never runs inside a scope
+_Mutex_lock _Real_mutex_lock() noexcept {
+    static const _Mutex_lock real = reinterpret_cast<_Mutex_lock>(::dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+    return real;
+}
+
+[[maybe_unused]] const _Mutex_lock _Resolved_at_startup = _Real_mutex_lock();
+
+} // namespace acpp::detail
+
+using acpp::rt_violation_kind;
+using acpp::detail::_Rt_check;
+
+extern "C" {
+
+void* malloc(std::size_t bytes) {
+    _Rt_check(rt_violation_kind::allocation, bytes);
+    return __libc_malloc(bytes);
+}
+
+void* calloc(std::size_t count, std::size_t bytes) {
+    _Rt_check(rt_violation_kind::allocation, count * bytes);
+    return __libc_calloc(count, bytes);
+}
+
+void* realloc(void* ptr, std::size_t bytes) {
+    _Rt_check(rt_violation_kind::allocation, bytes);
+    return __libc_realloc(ptr, bytes);
+}
+
+void* aligned_alloc(std::size_t align, std::size_t bytes) {
+    _Rt_check(rt_violation_kind::allocation, bytes);
+    return __libc_memalign(align, bytes);
+}
+
+int posix_memalign(void** out, std::size_t align, std::size_t bytes) {
+    _Rt_check(rt_violation_kind::allocation, bytes);
+    void* ptr = __libc_memalign(align, bytes);
+    if (!ptr) { return ENOMEM; }
+    *out = ptr;
+    return 0;
+}
+
+void free(void* ptr) {
+    if (ptr) { _Rt_check(rt_violation_kind::deallocation); }
+    __libc_free(ptr);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) {
+    _Rt_check(rt_violation_kind::lock);
+    return acpp::detail::_Real_mutex_lock()(mutex);
+}
+
+} // extern "C"
+
+// Replaced directly so one new is one report, not a new plus the malloc behind it.
+// The nothrow and array forms of libstdc++ end up in these.
+void* operator new(std::size_t bytes) {
+    _Rt_check(rt_violation_kind::allocation, bytes);
+    if (void* ptr = __libc_malloc(bytes ? bytes : 1)) { return ptr; }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t bytes, std::align_val_t align) {
+    _Rt_check(rt_violation_kind::allocation, bytes);
+    if (void* ptr = __libc_memalign(static_cast<std::size_t>(align), bytes ? bytes : 1)) { return ptr; }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr) { _Rt_check(rt_violation_kind::deallocation); }
+    __libc_free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    if (ptr) { _Rt_check(rt_violation_kind::deallocation); }
+    __libc_free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept { operator delete(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t align) noexcept { operator delete(ptr, align); }
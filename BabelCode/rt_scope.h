@@ -0,0 +1,110 @@
+#pragma once
+
+// Real-time safety checking for callback sections.
+// Code that must not allocate or lock (audio callbacks, packet handlers...) runs inside an
+// acpp::rt_scope. In checking builds (-DACPP_RT_CHECK, linking rt_scope.cpp) operator new,
+// the malloc family and pthread_mutex_lock are interposed, and any call made while a scope is
+// active on the thread is reported with the scope and the type of the callable that was being
+// invoked, constructed or copied by acpp::function at that moment. Without ACPP_RT_CHECK
+// rt_scope is an empty object.
+// System calls in general are not intercepted; only the ones behind these entry points are seen.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <source_location>
+#include <string_view>
+
+namespace acpp {
+
+enum class rt_violation_kind : uint8_t { allocation, deallocation, lock };
+
+enum class rt_violation_policy : uint8_t {
+    report, // write one line to stderr per violation and carry on
+    abort,  // report, then abort(); for CI runs that certify a hot path
+};
+
+namespace detail {
+
+struct _Rt_state {
+    uint32_t depth;
+    bool reporting; // set while a violation is being written, to ignore our own calls
+    const char* scope;
+    const char* file;
+    uint32_t line;
+    // Innermost callable acpp::function is working on, empty when none
+    const char* callable;
+    uint32_t callable_length;
+};
+
+// Trivial, so reading it from malloc never triggers a TLS constructor
+inline thread_local _Rt_state _Rt_current{};
+
+inline std::atomic<uint64_t> _Rt_violations{0};
+inline std::atomic<rt_violation_policy> _Rt_policy{rt_violation_policy::report};
+
+// Defined in rt_scope.cpp
+void _Rt_report(rt_violation_kind kind, std::size_t bytes) noexcept;
+
+inline bool _Rt_active() noexcept { return _Rt_current.depth != 0 && !_Rt_current.reporting; }
+
+// Names the callable acpp::function is invoking, storing or copying for the duration
+class _Rt_callable_frame {
+public:
+    explicit _Rt_callable_frame(std::string_view name) noexcept
+        : previous_{_Rt_current.callable}, previous_length_{_Rt_current.callable_length} {
+        _Rt_current.callable = name.data();
+        _Rt_current.callable_length = static_cast<uint32_t>(name.size());
+    }
+    _Rt_callable_frame(const _Rt_callable_frame&) = delete;
+    _Rt_callable_frame& operator=(const _Rt_callable_frame&) = delete;
+    ~_Rt_callable_frame() {
+        _Rt_current.callable = previous_;
+        _Rt_current.callable_length = previous_length_;
+    }
+
+private:
+    const char* previous_;
+    uint32_t previous_length_;
+};
+
+} // namespace detail
+
+/// Marks the current thread as real-time for its lifetime; scopes nest
+class rt_scope {
+public:
+#ifdef ACPP_RT_CHECK
+    explicit rt_scope(const char* name = "rt_scope", std::source_location location = std::source_location::current()) noexcept
+        : previous_{detail::_Rt_current} {
+        detail::_Rt_current.depth = previous_.depth + 1;
+        detail::_Rt_current.scope = name;
+        detail::_Rt_current.file = location.file_name();
+        detail::_Rt_current.line = location.line();
+    }
+    ~rt_scope() {
+        detail::_Rt_current.depth = previous_.depth;
+        detail::_Rt_current.scope = previous_.scope;
+        detail::_Rt_current.file = previous_.file;
+        detail::_Rt_current.line = previous_.line;
+    }
+#else
+    explicit rt_scope(const char* = "rt_scope", std::source_location = std::source_location::current()) noexcept {}
+#endif
+
+    rt_scope(const rt_scope&) = delete;
+    rt_scope& operator=(const rt_scope&) = delete;
+
+    /// Violations reported so far, all threads
+    static uint64_t violations() noexcept { return detail::_Rt_violations.load(std::memory_order_relaxed); }
+
+    static void set_policy(rt_violation_policy policy) noexcept {
+        detail::_Rt_policy.store(policy, std::memory_order_relaxed);
+    }
+
+private:
+#ifdef ACPP_RT_CHECK
+    detail::_Rt_state previous_;
+#endif
+};
+
+} // namespace acpp
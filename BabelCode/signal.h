@@ -0,0 +1,304 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "function.h"
+
+namespace acpp {
+namespace detail {
+
+// The part of a slot its connection sees. Slots are shared by every array that lists them,
+// so clearing live reaches emissions walking any of those arrays.
+struct _Slot_state {
+    std::atomic<bool> live{true};
+};
+
+// Type-erased back reference from a connection to the signal that owns the slot
+struct _Signal_link {
+    std::weak_ptr<void> core;
+    void (*disconnect)(void* core, const _Slot_state* slot){nullptr};
+};
+
+// Emissions running on this thread, over all signals: a writer inside one must not wait for
+// emissions to finish, as it would wait for itself
+inline thread_local unsigned _Signal_emitting = 0;
+
+} // namespace detail
+
+/// Handle to a connected slot. Outliving the signal is fine, disconnect() becomes a no-op.
+class connection {
+public:
+    connection() noexcept = default;
+
+    void disconnect() {
+        auto core = link_.core.lock();
+        auto slot = slot_.lock();
+        if (core && slot) { link_.disconnect(core.get(), slot.get()); }
+        link_.core.reset();
+        slot_.reset();
+    }
+
+    /// False once disconnected, by this handle, by disconnect_all() or by the signal's end
+    bool connected() const noexcept {
+        auto slot = slot_.lock();
+        return slot && slot->live.load(std::memory_order_acquire);
+    }
+    explicit operator bool() const noexcept { return connected(); }
+
+private:
+    template <typename... Args>
+    friend class signal;
+
+    connection(detail::_Signal_link link, std::weak_ptr<const detail::_Slot_state> slot) noexcept
+        : link_{std::move(link)}, slot_{std::move(slot)} {}
+
+    detail::_Signal_link link_;
+    std::weak_ptr<const detail::_Slot_state> slot_;
+};
+
+/// Disconnects on destruction
+class scoped_connection {
+public:
+    scoped_connection() noexcept = default;
+    scoped_connection(connection conn) noexcept : conn_{std::move(conn)} {}
+    scoped_connection(scoped_connection&&) noexcept = default;
+    scoped_connection& operator=(scoped_connection&& oth) noexcept {
+        if (this != &oth) { conn_.disconnect(); conn_ = std::move(oth.conn_); }
+        return *this;
+    }
+    ~scoped_connection() { conn_.disconnect(); }
+
+    void disconnect() { conn_.disconnect(); }
+    connection release() noexcept { return std::exchange(conn_, connection{}); }
+    bool connected() const noexcept { return conn_.connected(); }
+
+private:
+    connection conn_;
+};
+
+template <typename... Args>
+class signal;
+
+/// Observer list with lock-free, wait-free emission.
+/// Each slot is allocated once and shared by reference. Writers publish an immutable array of
+/// slot pointers (copy-on-write) under their mutex; emission never takes it and never frees
+/// anything. An emission costs two uncontended atomic adds, which count it under the current
+/// epoch. A replaced array is freed by a later writer once the epoch has advanced twice, each
+/// advance waiting until the emissions counted two epochs back are done. A slot disconnected
+/// while an emission runs is flagged dead and skipped. Once many replaced arrays are pending,
+/// a writer waits for the emissions in progress, without holding the mutex, unless it is
+/// itself running inside an emission.
+template <typename... Args>
+class signal<void(Args...)> {
+private:
+    using _Slot_function = function<void(Args...)>;
+    using _Identity = std::array<std::byte, sizeof(_Slot_function)>;
+
+    static_assert(sizeof(_Slot_function) == sizeof(detail::_Any_callable) + sizeof(void*),
+                  "connect_unique compares whole function images, which must have no padding");
+
+    struct _Slot : detail::_Slot_state {
+        _Slot(const _Identity& image, _Slot_function&& f) : identity{image}, fn{std::move(f)} {}
+
+        // Bit image of the function as connected: connect_unique compares these, never fn,
+        // which an emission may be changing
+        const _Identity identity;
+        mutable _Slot_function fn;
+    };
+
+    struct _Slot_array {
+        explicit _Slot_array(std::size_t n) : size{n}, slots{std::make_unique<std::shared_ptr<_Slot>[]>(n)} {}
+        std::size_t size;
+        std::unique_ptr<std::shared_ptr<_Slot>[]> slots;
+    };
+
+    struct _Core {
+        // Replaced arrays past this many make a writer wait for the emissions in progress
+        static constexpr std::size_t _Max_retired = 16;
+
+        struct alignas(64) _Readers {
+            std::atomic<std::size_t> count{0};
+        };
+
+        std::atomic<_Slot_array*> slots{nullptr};
+        _Readers readers[2];                     // emissions in progress, by epoch parity
+        alignas(64) std::atomic<uint64_t> epoch{0};
+        std::mutex write_mutex;
+        // Replaced arrays with the epoch they were replaced in
+        std::vector<std::pair<uint64_t, std::unique_ptr<_Slot_array>>> retired;
+
+        ~_Core() { delete slots.load(std::memory_order_relaxed); }
+
+        // Advances the epoch if no emission counted two epochs back is left. Every counter is
+        // checked after the arrays retired before it were replaced, so an emission that starts
+        // counting after the check loads a newer array (all seq_cst), and two advances after an
+        // array was replaced none can still be reading it.
+        bool try_advance() noexcept {
+            uint64_t e = epoch.load();
+            return readers[(e + 1) & 1].count.load() == 0 && epoch.compare_exchange_strong(e, e + 1);
+        }
+
+        // Under write_mutex: frees what no emission can reach. True when too much is left.
+        bool collect() {
+            while (!retired.empty()) {
+                uint64_t e = epoch.load();
+                std::erase_if(retired, [e](const auto& entry) { return entry.first + 2 <= e; });
+                if (retired.empty() || !try_advance()) { break; }
+            }
+            return retired.size() > _Max_retired;
+        }
+
+        // Under write_mutex. True when the writer should call drain() once it has unlocked.
+        bool publish(std::unique_ptr<_Slot_array> next) {
+            if (next && next->size == 0) { next.reset(); }
+            if (_Slot_array* prev = slots.exchange(next.release())) { retired.emplace_back(epoch.load(), prev); }
+            return collect();
+        }
+
+        // Waits out the emissions in progress, then frees what they were reading
+        void drain() {
+            if (detail::_Signal_emitting != 0) { return; }
+            uint64_t target = epoch.load() + 2;
+            while (epoch.load() < target) {
+                if (!try_advance()) { std::this_thread::yield(); }
+            }
+            std::lock_guard lock(write_mutex);
+            collect();
+        }
+
+        static void disconnect(void* self, const detail::_Slot_state* slot) {
+            auto& core = *static_cast<_Core*>(self);
+            bool crowded;
+            {
+                std::lock_guard lock(core.write_mutex);
+                _Slot_array* current = core.slots.load(std::memory_order_relaxed);
+                if (!current) { return; }
+                std::size_t found = current->size;
+                for (std::size_t i = 0; i < current->size; ++i) {
+                    if (current->slots[i].get() == slot) { found = i; break; }
+                }
+                if (found == current->size) { return; }
+                // Emissions still walking an older array must not call it anymore
+                current->slots[found]->live.store(false, std::memory_order_release);
+                auto next = std::make_unique<_Slot_array>(current->size - 1);
+                std::copy(current->slots.get(), current->slots.get() + found, next->slots.get());
+                std::copy(current->slots.get() + found + 1, current->slots.get() + current->size,
+                          next->slots.get() + found);
+                crowded = core.publish(std::move(next));
+            }
+            if (crowded) { core.drain(); }
+        }
+    };
+
+    // Counts an emission under the current epoch while it reads the array
+    struct _Emit_guard {
+        std::atomic<std::size_t>& readers;
+        const _Slot_array* array;
+        explicit _Emit_guard(_Core& core) noexcept
+            : readers{core.readers[core.epoch.load(std::memory_order_relaxed) & 1].count} {
+            readers.fetch_add(1); // seq_cst: ordered before the load of the array
+            array = core.slots.load();
+            ++detail::_Signal_emitting;
+        }
+        ~_Emit_guard() {
+            --detail::_Signal_emitting;
+            readers.fetch_sub(1, std::memory_order_release);
+        }
+    };
+
+    static _Identity _Identity_of(const _Slot_function& fn) noexcept {
+        _Identity image;
+        std::memcpy(image.data(), static_cast<const void*>(&fn), image.size());
+        return image;
+    }
+
+public:
+    signal() : core_{std::make_shared<_Core>()} {}
+    signal(const signal&) = delete;
+    signal& operator=(const signal&) = delete;
+
+    template <typename Callable>
+    connection connect(Callable&& callable) {
+        return add(_Slot_function(std::forward<Callable>(callable)), false);
+    }
+
+    /// Same as connect, but returns an empty connection when an identical slot
+    /// (same callable type and bitwise equal inline state when connected) is already connected
+    template <typename Callable>
+    connection connect_unique(Callable&& callable) {
+        return add(_Slot_function(std::forward<Callable>(callable)), true);
+    }
+
+    void disconnect_all() {
+        bool crowded;
+        {
+            std::lock_guard lock(core_->write_mutex);
+            _Slot_array* current = core_->slots.load(std::memory_order_relaxed);
+            if (!current) { return; }
+            for (std::size_t i = 0; i < current->size; ++i) {
+                current->slots[i]->live.store(false, std::memory_order_release);
+            }
+            crowded = core_->publish(nullptr);
+        }
+        if (crowded) { core_->drain(); }
+    }
+
+    std::size_t size() const {
+        _Emit_guard guard(*core_);
+        return guard.array ? guard.array->size : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    void operator()(Args... args) const { emit(args...); }
+
+    void emit(Args... args) const {
+        _Emit_guard guard(*core_);
+        const _Slot_array* current = guard.array;
+        if (!current) { return; }
+        const std::shared_ptr<_Slot>* slot = current->slots.get();
+        const std::shared_ptr<_Slot>* end = slot + current->size;
+        for (; slot != end; ++slot) {
+            if ((*slot)->live.load(std::memory_order_acquire)) { (*slot)->fn(args...); }
+        }
+    }
+
+private:
+    connection add(_Slot_function fn, bool unique) {
+        std::shared_ptr<_Slot> slot;
+        bool crowded;
+        {
+            std::lock_guard lock(core_->write_mutex);
+            _Slot_array* current = core_->slots.load(std::memory_order_relaxed);
+            std::size_t size = current ? current->size : 0;
+            _Identity identity = _Identity_of(fn);
+            if (unique) {
+                for (std::size_t i = 0; i < size; ++i) {
+                    if (current->slots[i]->identity == identity) { return connection{}; }
+                }
+            }
+            slot = std::make_shared<_Slot>(identity, std::move(fn));
+            auto next = std::make_unique<_Slot_array>(size + 1);
+            if (size) { std::copy(current->slots.get(), current->slots.get() + size, next->slots.get()); }
+            next->slots[size] = slot;
+            crowded = core_->publish(std::move(next));
+        }
+        if (crowded) { core_->drain(); }
+        return connection{detail::_Signal_link{core_, &_Core::disconnect}, std::move(slot)};
+    }
+
+private:
+    std::shared_ptr<_Core> core_;
+};
+
+} // namespace acpp
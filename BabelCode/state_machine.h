@@ -0,0 +1,179 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <new>
+#include <span>
+#include <type_traits>
+
+#include "any_of.h"
+
+namespace acpp {
+
+/// Number of enumerators of a state or event enum. Defaults to E::count, specialize otherwise.
+template <typename E>
+struct enum_count {
+    static constexpr std::size_t value = static_cast<std::size_t>(E::count);
+};
+
+namespace detail {
+
+// Erased callable for transition table cells. Function pointers and captureless lambdas are
+// stored as plain pointers so a table made of them can be constant-initialized; small trivially
+// copyable closures are stored inline. Nothing is ever heap allocated or destroyed, so a cell
+// needs no vtable, only any_of's call thunk for what it holds.
+template <typename Sig>
+class _Table_callable;
+
+template <typename R, typename Context>
+class _Table_callable<R(Context&)> {
+private:
+    using _Fn_ptr = R (*)(Context&);
+
+    struct _Call {
+        using signature = R(const self&, Context&);
+        template <typename Callable>
+        static R call(const Callable& callable, Context& context) { return callable(context); }
+    };
+    using _Invoker = _Operation_traits<typename _Call::signature>::pointer;
+
+    template <typename Callable>
+    static constexpr _Invoker _Thunk = &_Any_thunk<_Call, _Any_object<Callable, true>>::call;
+
+public:
+    static constexpr std::size_t inline_bytes = 2 * sizeof(void*);
+
+    template <typename Callable>
+    static constexpr bool _Storable_inline = sizeof(Callable) <= inline_bytes &&
+                                             alignof(void*) % alignof(Callable) == 0 &&
+                                             std::is_trivially_copyable_v<Callable> &&
+                                             std::is_trivially_destructible_v<Callable>;
+
+    constexpr _Table_callable() noexcept = default;
+
+    constexpr _Table_callable(_Fn_ptr fn) noexcept : invoker_{fn ? _Thunk<_Fn_ptr> : nullptr} { storage_.fn = fn; }
+
+    template <typename Callable>
+        requires std::convertible_to<Callable, _Fn_ptr> && (!std::same_as<std::decay_t<Callable>, _Fn_ptr>)
+    constexpr _Table_callable(Callable callable) noexcept : _Table_callable(static_cast<_Fn_ptr>(callable)) {}
+
+    template <typename Callable>
+        requires (!std::convertible_to<Callable, _Fn_ptr>) &&
+                 std::is_invocable_r_v<R, const Callable&, Context&> && _Storable_inline<Callable>
+    _Table_callable(const Callable& callable) noexcept : invoker_{_Thunk<Callable>} {
+        new (storage_.bytes) Callable(callable);
+    }
+
+    constexpr explicit operator bool() const noexcept { return invoker_ != nullptr; }
+
+    R operator()(Context& context) const { return invoker_(&storage_, context); }
+
+private:
+    union _Storage {
+        constexpr _Storage() noexcept : fn{nullptr} {}
+        _Fn_ptr fn;
+        alignas(void*) unsigned char bytes[inline_bytes];
+    };
+
+    _Storage storage_;
+    _Invoker invoker_{nullptr};
+};
+
+} // namespace detail
+
+/// Dense [state][event] transition table. Built with constexpr calls, so a table whose guards
+/// and actions are function pointers or captureless lambdas can be a constexpr variable.
+template <typename State, typename Event, typename Context>
+class transition_table {
+public:
+    using guard_type = detail::_Table_callable<bool(Context&)>;
+    using action_type = detail::_Table_callable<void(Context&)>;
+
+    static constexpr std::size_t state_count = enum_count<State>::value;
+    static constexpr std::size_t event_count = enum_count<Event>::value;
+
+    struct cell {
+        guard_type guard;
+        action_type action;
+        State target{};
+        bool defined{false};
+    };
+
+    constexpr transition_table() noexcept = default;
+
+    constexpr transition_table& on(State from, Event event, State to, action_type action = {}) noexcept {
+        return on_guarded(from, event, guard_type{}, to, action);
+    }
+
+    /// The transition only fires when the guard returns true
+    constexpr transition_table& on_guarded(State from, Event event, guard_type guard, State to,
+                                           action_type action = {}) noexcept {
+        cells_[_Index(from)][_Index(event)] = cell{guard, action, to, true};
+        return *this;
+    }
+
+    constexpr const cell& at(State from, Event event) const noexcept {
+        return cells_[_Index(from)][_Index(event)];
+    }
+
+private:
+    template <typename E>
+    static constexpr std::size_t _Index(E e) noexcept { return static_cast<std::size_t>(e); }
+
+    std::array<std::array<cell, event_count>, state_count> cells_{};
+};
+
+/// Table-driven state machine. process() is one table lookup plus at most two indirect calls.
+/// The action runs before the state changes; unhandled or guarded-out events leave the state as is.
+/// The table is referenced, not copied, and must outlive the machine.
+template <typename State, typename Event, typename Context>
+class state_machine {
+public:
+    using table_type = transition_table<State, Event, Context>;
+
+    state_machine(const table_type& table, State initial, Context& context) noexcept
+        : table_{&table}, state_{initial}, context_{&context} {}
+
+    State state() const noexcept { return state_; }
+    void reset(State state) noexcept { state_ = state; }
+    Context& context() const noexcept { return *context_; }
+
+    /// Returns whether the event caused a transition
+    bool process(Event event) {
+        const auto& cell = table_->at(state_, event);
+        if (!cell.defined) { return false; }
+        if (cell.guard && !cell.guard(*context_)) { return false; }
+        if (cell.action) { cell.action(*context_); }
+        state_ = cell.target;
+        return true;
+    }
+
+    /// Feeds a whole event stream; returns how many events caused a transition
+    std::size_t process_batch(std::span<const Event> events) {
+        const table_type& table = *table_;
+        Context& context = *context_;
+        State state = state_;
+        std::size_t fired = 0;
+        for (Event event : events) {
+            const auto& cell = table.at(state, event);
+            if (!cell.defined || (cell.guard && !cell.guard(context))) { continue; }
+            if (cell.action) {
+                // Actions may look at the machine, keep it in sync
+                state_ = state;
+                cell.action(context);
+            }
+            state = cell.target;
+            ++fired;
+        }
+        state_ = state;
+        return fired;
+    }
+
+private:
+    const table_type* table_;
+    State state_;
+    Context* context_;
+};
+
+} // namespace acpp
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <source_location>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include <pthread.h>
+
+#include "once_function.h"
+
+#ifdef ACPP_TRACE
+#include "trace.h"
+#endif
+#ifdef ACPP_TASK_LATENCY
+#include "latency_histogram.h"
+#endif
+
+namespace acpp {
+namespace detail {
+
+// One-shot signal to a waiting thread that may destroy the handshake as soon as wait()
+// returns. The notify call still touches the atomic after the store it wakes on, so the
+// signaller ends with one more store and the waiter returns only once it sees that one.
+class _Handshake {
+public:
+    void notify() noexcept {
+        state_.store(_Signalled, std::memory_order_release);
+        state_.notify_one();
+        state_.store(_Released, std::memory_order_release); // last access by the signaller
+    }
+
+    void wait() noexcept {
+        state_.wait(_Waiting, std::memory_order_acquire);
+        // Only the few instructions of notify_one() left
+        while (state_.load(std::memory_order_acquire) != _Released) { std::this_thread::yield(); }
+    }
+
+private:
+    static constexpr uint32_t _Waiting = 0;
+    static constexpr uint32_t _Signalled = 1;
+    static constexpr uint32_t _Released = 2;
+
+    std::atomic<uint32_t> state_{_Waiting};
+};
+
+} // namespace detail
+
+/// std::thread-like thread whose entry point is a once_function kept inline (no shared
+/// state block is allocated). The new thread moves the entry onto its own stack before the
+/// constructor returns, so the thread object can be moved freely afterwards.
+class thread {
+public:
+    thread() noexcept = default;
+
+    // The source location is only used by ACPP_TRACE builds, to name the entry's task
+    template <typename Callable> requires _Is_valid_once_callable<Callable, void>
+    explicit thread(Callable&& callable, [[maybe_unused]] std::source_location location = std::source_location::current()) {
+        _Start start{once_function<void()>(std::forward<Callable>(callable)), {}};
+#ifdef ACPP_TASK_LATENCY
+        start.created_ns = detail::_Latency_clock_ns();
+#endif
+#ifdef ACPP_TRACE
+        if (trace::enabled()) [[unlikely]] {
+            start.trace_task = trace::task_of<std::decay_t<Callable>>(location);
+            start.trace_id = trace::enqueue(start.trace_task);
+        }
+#endif
+        if (int err = ::pthread_create(&handle_, nullptr, &_Run, &start)) {
+            throw std::system_error(err, std::generic_category(), "acpp::thread");
+        }
+        joinable_ = true;
+        // Wait until the entry has left this stack frame
+        start.taken.wait();
+    }
+
+    thread(const thread&) = delete;
+    thread& operator=(const thread&) = delete;
+
+    thread(thread&& oth) noexcept
+        : handle_{oth.handle_}, joinable_{std::exchange(oth.joinable_, false)} {}
+
+    thread& operator=(thread&& oth) noexcept {
+        if (joinable_) { std::terminate(); }
+        handle_ = oth.handle_;
+        joinable_ = std::exchange(oth.joinable_, false);
+        return *this;
+    }
+
+    ~thread() {
+        if (joinable_) { std::terminate(); }
+    }
+
+#ifdef ACPP_TASK_LATENCY
+    /// Start delay (constructor entered to entry running) and run time of every acpp::thread
+    static task_latency& latency() {
+        static task_latency histograms;
+        return histograms;
+    }
+#endif
+
+    bool joinable() const noexcept { return joinable_; }
+    pthread_t native_handle() const noexcept { return handle_; }
+
+    void join() {
+        if (!joinable_) { throw std::system_error(std::make_error_code(std::errc::invalid_argument), "acpp::thread::join"); }
+        if (int err = ::pthread_join(handle_, nullptr)) {
+            throw std::system_error(err, std::generic_category(), "acpp::thread::join");
+        }
+        joinable_ = false;
+    }
+
+    void detach() {
+        if (!joinable_) { throw std::system_error(std::make_error_code(std::errc::invalid_argument), "acpp::thread::detach"); }
+        if (int err = ::pthread_detach(handle_)) {
+            throw std::system_error(err, std::generic_category(), "acpp::thread::detach");
+        }
+        joinable_ = false;
+    }
+
+private:
+    struct _Start {
+        once_function<void()> entry;
+        detail::_Handshake taken;
+#ifdef ACPP_TRACE
+        uint64_t trace_id{0};
+        trace::task_info trace_task{};
+#endif
+#ifdef ACPP_TASK_LATENCY
+        uint64_t created_ns{0};
+#endif
+    };
+
+    static void* _Run(void* ctx) noexcept {
+        auto& start = *static_cast<_Start*>(ctx);
+        once_function<void()> entry(std::move(start.entry));
+#ifdef ACPP_TASK_LATENCY
+        uint64_t started_ns = detail::_Latency_clock_ns();
+        latency().queue_delay.record(started_ns - start.created_ns);
+        struct _Run_timer {
+            uint64_t started_ns;
+            ~_Run_timer() { latency().run_time.record(detail::_Latency_clock_ns() - started_ns); }
+        } run_timer{started_ns};
+#endif
+#ifdef ACPP_TRACE
+        uint64_t trace_id = start.trace_id;
+        trace::task_info task = start.trace_task;
+#endif
+        // start is gone once this returns
+        start.taken.notify();
+#ifdef ACPP_TRACE
+        if (trace_id) [[unlikely]] {
+            trace::start(trace_id, task);
+            std::move(entry)();
+            trace::finish(trace_id, task);
+            return nullptr;
+        }
+#endif
+        std::move(entry)();
+        return nullptr;
+    }
+
+    pthread_t handle_{};
+    bool joinable_{false};
+};
+
+} // namespace acpp
@@ -0,0 +1,222 @@
+#pragma once
+
+// Task timeline tracing for the executors and queues, compiled in with -DACPP_TRACE.
+// Each task records enqueue, start and finish events (timestamp, thread, callable type name,
+// construction site) into a lock-free ring owned by the recording thread. flush() appends
+// everything recorded since the last flush to a Chrome trace JSON file, which chrome://tracing
+// and Perfetto open; the file is kept open and stays valid JSON after every flush.
+// While tracing is disabled an instrumented call site costs one load and one branch.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "type_name.h"
+
+#ifndef ACPP_TRACE_RING_EVENTS
+#define ACPP_TRACE_RING_EVENTS 16384
+#endif
+
+namespace acpp::trace {
+
+/// What a task is: the callable's type and where the task was created
+struct task_info {
+    std::string_view name;
+    const char* file;
+    uint32_t line;
+};
+
+template <typename Callable>
+task_info task_of(const std::source_location& location) noexcept {
+    return {acpp::detail::_Type_name_v<Callable>, location.file_name(), location.line()};
+}
+
+namespace detail {
+
+enum class _Phase : uint8_t { enqueue, start, finish };
+
+struct _Event {
+    uint64_t timestamp_ns;
+    uint64_t task_id;
+    task_info task;
+    _Phase phase;
+};
+
+// Single producer (the owning thread), single consumer (flush, under the registry lock).
+// A full ring drops new events instead of blocking the task.
+struct _Ring {
+    static constexpr uint64_t capacity = ACPP_TRACE_RING_EVENTS;
+    static_assert((capacity & (capacity - 1)) == 0, "ACPP_TRACE_RING_EVENTS must be a power of two");
+
+    std::unique_ptr<_Event[]> events{new _Event[capacity]};
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};
+    std::atomic<uint64_t> dropped{0};
+    uint32_t thread_index;
+    long os_tid;
+    uint64_t next_task{0};
+
+    void push(const _Event& event) noexcept {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == capacity) {
+            dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        events[h & (capacity - 1)] = event;
+        head.store(h + 1, std::memory_order_release);
+    }
+};
+
+inline std::atomic<bool> _Enabled{false};
+
+class _Registry {
+public:
+    static _Registry& instance() {
+        static _Registry registry;
+        return registry;
+    }
+
+    ~_Registry() {
+        if (out_) { std::fclose(out_); }
+    }
+
+    _Ring& ring() {
+        thread_local _Ring* local = nullptr;
+        if (!local) [[unlikely]] {
+            // Rings outlive their thread so exited threads still make it into the file
+            auto ring = std::make_shared<_Ring>();
+            ring->os_tid = ::syscall(SYS_gettid);
+            std::lock_guard lock(mutex_);
+            ring->thread_index = static_cast<uint32_t>(rings_.size());
+            rings_.push_back(ring);
+            local = ring.get();
+        }
+        return *local;
+    }
+
+    // The first flush to a path creates the file; later ones write over its closing "]}" and
+    // append, so every flush leaves a complete trace holding all events so far
+    bool flush(const char* path) {
+        std::lock_guard lock(mutex_);
+        if (!out_ || path_ != path) {
+            if (out_) { std::fclose(out_); }
+            out_ = std::fopen(path, "w");
+            if (!out_) { return false; }
+            path_ = path;
+            named_ = 0;
+            std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", out_);
+        } else if (std::fseek(out_, trailer_, SEEK_SET) != 0) {
+            return false;
+        }
+        // Thread names once per file, before that thread's first event
+        for (; named_ < rings_.size(); ++named_) { write_metadata(out_, *rings_[named_], named_ == 0); }
+        for (const auto& ring : rings_) {
+            uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            for (; tail != head; ++tail) { write_event(out_, *ring, ring->events[tail & (_Ring::capacity - 1)]); }
+            ring->tail.store(tail, std::memory_order_release);
+        }
+        trailer_ = std::ftell(out_);
+        std::fputs("\n]}\n", out_);
+        return std::fflush(out_) == 0 && !std::ferror(out_);
+    }
+
+    uint64_t dropped() {
+        std::lock_guard lock(mutex_);
+        uint64_t total = 0;
+        for (const auto& ring : rings_) { total += ring->dropped.load(std::memory_order_relaxed); }
+        return total;
+    }
+
+private:
+    static void write_metadata(std::FILE* out, const _Ring& ring, bool first) {
+        std::fprintf(out, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %ld\"}}",
+                     first ? "" : ",\n", ring.thread_index, ring.os_tid);
+    }
+
+    static void write_string(std::FILE* out, std::string_view text) {
+        std::fputc('"', out);
+        for (char c : text) {
+            if (c == '"' || c == '\\') { std::fputc('\\', out); }
+            std::fputc(static_cast<unsigned char>(c) < 0x20 ? ' ' : c, out);
+        }
+        std::fputc('"', out);
+    }
+
+    static void write_event(std::FILE* out, const _Ring& ring, const _Event& event) {
+        double ts = static_cast<double>(event.timestamp_ns) / 1e3;
+        // Enqueue is a zero length slice that starts a flow arrow; start binds the arrow's end
+        static constexpr const char* phases[] = {"X", "B", "E"};
+        std::fputs(",\n{\"name\":", out);
+        write_string(out, event.task.name);
+        std::fprintf(out, ",\"cat\":\"task\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,",
+                     phases[static_cast<int>(event.phase)], ts, ring.thread_index);
+        if (event.phase == _Phase::enqueue) { std::fputs("\"dur\":0,", out); }
+        std::fputs("\"args\":{\"site\":", out);
+        write_string(out, event.task.file);
+        std::fprintf(out, ",\"line\":%u,\"task\":%llu,\"event\":\"%s\"}}", event.task.line,
+                     static_cast<unsigned long long>(event.task_id),
+                     event.phase == _Phase::enqueue ? "enqueue" : event.phase == _Phase::start ? "start" : "finish");
+        if (event.phase != _Phase::finish) {
+            std::fprintf(out, ",\n{\"name\":\"task\",\"cat\":\"task\",\"ph\":\"%s\",%s\"id\":%llu,\"ts\":%.3f,\"pid\":1,\"tid\":%u}",
+                         event.phase == _Phase::enqueue ? "s" : "f", event.phase == _Phase::start ? "\"bp\":\"e\"," : "",
+                         static_cast<unsigned long long>(event.task_id), ts, ring.thread_index);
+        }
+    }
+
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<_Ring>> rings_;
+    std::FILE* out_{nullptr};
+    std::string path_;
+    std::size_t named_{0};   // rings whose thread name is in the file
+    long trailer_{0};        // offset of the closing "]}"
+};
+
+inline uint64_t _Now() noexcept {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch).count());
+}
+
+inline void _Record(_Phase phase, uint64_t task_id, const task_info& task) {
+    _Registry::instance().ring().push({_Now(), task_id, task, phase});
+}
+
+} // namespace detail
+
+inline void enable() noexcept { detail::_Enabled.store(true, std::memory_order_relaxed); }
+inline void disable() noexcept { detail::_Enabled.store(false, std::memory_order_relaxed); }
+
+/// The one branch instrumented call sites pay while tracing is off
+inline bool enabled() noexcept { return detail::_Enabled.load(std::memory_order_relaxed); }
+
+/// Records the enqueue of a task and returns its id (never 0) for start and finish
+inline uint64_t enqueue(const task_info& task) {
+    detail::_Ring& ring = detail::_Registry::instance().ring();
+    // Unique without coordination: thread index in the top bits, per-thread count below
+    uint64_t id = (static_cast<uint64_t>(ring.thread_index + 1) << 40) | ++ring.next_task;
+    detail::_Record(detail::_Phase::enqueue, id, task);
+    return id;
+}
+
+inline void start(uint64_t task_id, const task_info& task) { detail::_Record(detail::_Phase::start, task_id, task); }
+inline void finish(uint64_t task_id, const task_info& task) { detail::_Record(detail::_Phase::finish, task_id, task); }
+
+/// Appends the events recorded since the last flush to a Chrome trace JSON file, creating it
+/// on the first flush to that path; the file is complete after every call
+inline bool flush(const char* path) { return detail::_Registry::instance().flush(path); }
+
+/// Events lost to full rings since the start
+inline uint64_t dropped() { return detail::_Registry::instance().dropped(); }
+
+} // namespace acpp::trace
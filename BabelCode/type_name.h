@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string_view>
+
+namespace acpp {
+namespace detail {
+
+// Readable name of T from the compiler's function signature; points into static storage
+template <typename T>
+constexpr std::string_view _Type_name() noexcept {
+    std::string_view name = __PRETTY_FUNCTION__;
+    std::size_t begin = name.find("T = ");
+    if (begin == std::string_view::npos) { return name; }
+    begin += 4;
+    std::size_t end = name.find_first_of(";]", begin);
+    return name.substr(begin, end - begin);
+}
+
+// Same, computed at compile time; use this on hot paths
+template <typename T>
+inline constexpr std::string_view _Type_name_v = _Type_name<T>();
+
+} // namespace detail
+} // namespace acpp
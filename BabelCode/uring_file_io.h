@@ -0,0 +1,592 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <source_location>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "any_of.h"
+
+#ifdef ACPP_TRACE
+#include "trace.h"
+#endif
+#ifdef ACPP_TASK_LATENCY
+#include "latency_histogram.h"
+#endif
+
+namespace acpp {
+namespace detail {
+
+// The call a completion supports
+struct _Complete {
+    using signature = void(self&, int result);
+    static void call(auto& handler, int result) { handler(result); }
+};
+
+// Move-only, call-once completion stored inline in a slab slot: a unique_any_of, so callables
+// that don't fit the slot are spilled to the heap. Moving leaves the source empty, so a slot
+// can be recycled while its handler runs from elsewhere.
+class _Completion {
+public:
+    static constexpr std::size_t inline_bytes = 48;
+
+    template <typename Callable>
+    void set(Callable&& callable) {
+        handler_.template emplace<std::decay_t<Callable>>(std::forward<Callable>(callable));
+    }
+
+    // Runs the completion and leaves the slot empty; the captured state is gone before returning,
+    // also when the handler throws.
+    void invoke_and_reset(int result) {
+        struct _Reset {
+            _Handler& handler;
+            ~_Reset() { handler.reset(); }
+        } guard{handler_};
+        handler_.call<_Complete>(result);
+    }
+
+    void reset() noexcept { handler_.reset(); }
+
+    explicit operator bool() const noexcept { return static_cast<bool>(handler_); }
+
+private:
+    using _Handler = unique_any_of<interface<_Complete>, inline_bytes>;
+
+    _Handler handler_;
+};
+
+enum class _Io_op : uint8_t { read, write, fsync, read_fixed, write_fixed };
+
+// One in-flight request; its index in the slab is the io_uring user_data
+struct _Io_request {
+    _Io_op op;
+    int fd;
+    void* buf;
+    uint32_t len;
+    uint16_t buf_index;
+    off_t offset;
+    _Completion completion;
+    uint32_t next_free;
+#ifdef ACPP_TRACE
+    uint64_t trace_id;
+    trace::task_info trace_task;
+#endif
+#ifdef ACPP_TASK_LATENCY
+    uint64_t enqueued_ns;
+#endif
+};
+
+inline int _Sys_io_uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+inline int _Sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+inline int _Sys_io_uring_register(int fd, unsigned opcode, const void* arg, unsigned nr_args) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+// Minimal raw io_uring: SQ/CQ rings mapped straight from the kernel, no liburing
+class _Uring {
+public:
+    bool open(unsigned entries) {
+        io_uring_params params{};
+        fd_ = _Sys_io_uring_setup(entries, &params);
+        if (fd_ < 0) { fd_ = -1; return false; }
+
+        sq_ring_bytes_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_bytes_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        single_mmap_ = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap_) { sq_ring_bytes_ = cq_ring_bytes_ = std::max(sq_ring_bytes_, cq_ring_bytes_); }
+
+        sq_ring_ = ::mmap(nullptr, sq_ring_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          fd_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED) { sq_ring_ = nullptr; close(); return false; }
+        cq_ring_ = single_mmap_ ? sq_ring_
+                                : ::mmap(nullptr, cq_ring_bytes_, PROT_READ | PROT_WRITE,
+                                         MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) { cq_ring_ = nullptr; close(); return false; }
+        sqes_bytes_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(::mmap(nullptr, sqes_bytes_, PROT_READ | PROT_WRITE,
+                                                  MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES));
+        if (sqes_ == MAP_FAILED) { sqes_ = nullptr; close(); return false; }
+
+        auto* sq = static_cast<char*>(sq_ring_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sq_entries_ = params.sq_entries;
+
+        auto* cq = static_cast<char*>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        cq_entries_ = params.cq_entries;
+        return true;
+    }
+
+    void close() noexcept {
+        if (sqes_) { ::munmap(sqes_, sqes_bytes_); sqes_ = nullptr; }
+        if (cq_ring_ && cq_ring_ != sq_ring_) { ::munmap(cq_ring_, cq_ring_bytes_); }
+        if (sq_ring_) { ::munmap(sq_ring_, sq_ring_bytes_); }
+        sq_ring_ = cq_ring_ = nullptr;
+        if (fd_ >= 0) { ::close(fd_); fd_ = -1; }
+    }
+
+    // Returns nullptr when the SQ is full; the caller has to submit first
+    io_uring_sqe* get_sqe() noexcept {
+        unsigned head = std::atomic_ref<unsigned>(*sq_head_).load(std::memory_order_acquire);
+        if (sq_local_tail_ - head >= sq_entries_) { return nullptr; }
+        unsigned index = sq_local_tail_++ & sq_mask_;
+        sq_array_[index] = index;
+        io_uring_sqe* sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    // Publishes every queued SQE with a single io_uring_enter. Counted from the kernel's head,
+    // so SQEs it left behind in an earlier, partial submit go too.
+    int submit(unsigned min_complete = 0) noexcept {
+        unsigned head = std::atomic_ref<unsigned>(*sq_head_).load(std::memory_order_acquire);
+        unsigned to_submit = sq_local_tail_ - head;
+        if (to_submit == 0 && min_complete == 0) { return 0; }
+        std::atomic_ref<unsigned>(*sq_tail_).store(sq_local_tail_, std::memory_order_release);
+        unsigned flags = min_complete ? IORING_ENTER_GETEVENTS : 0;
+        int ret;
+        do {
+            ret = _Sys_io_uring_enter(fd_, to_submit, min_complete, flags);
+        } while (ret < 0 && errno == EINTR);
+        return ret;
+    }
+
+    template <typename OnCqe>
+    unsigned reap(OnCqe&& on_cqe) {
+        const unsigned tail = std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire);
+        unsigned count = 0;
+        while (true) {
+            // Reloaded every time: a handler that polls or waits reaps further CQEs itself
+            unsigned head = std::atomic_ref<unsigned>(*cq_head_).load(std::memory_order_relaxed);
+            if (static_cast<int>(tail - head) <= 0) { break; }
+            io_uring_cqe cqe = cqes_[head & cq_mask_];
+            // Hand the slot back before running the handler, it may queue more work
+            std::atomic_ref<unsigned>(*cq_head_).store(head + 1, std::memory_order_release);
+            on_cqe(cqe.user_data, cqe.res);
+            ++count;
+        }
+        return count;
+    }
+
+    int register_buffers(std::span<const iovec> buffers) noexcept {
+        int ret = _Sys_io_uring_register(fd_, IORING_REGISTER_BUFFERS, buffers.data(),
+                                         static_cast<unsigned>(buffers.size()));
+        return ret < 0 ? -errno : 0;
+    }
+
+    int unregister_buffers() noexcept {
+        int ret = _Sys_io_uring_register(fd_, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+        return ret < 0 ? -errno : 0;
+    }
+
+    unsigned sq_entries() const noexcept { return sq_entries_; }
+    unsigned cq_entries() const noexcept { return cq_entries_; }
+
+private:
+    int fd_{-1};
+    void* sq_ring_{nullptr};
+    void* cq_ring_{nullptr};
+    io_uring_sqe* sqes_{nullptr};
+    std::size_t sq_ring_bytes_{0};
+    std::size_t cq_ring_bytes_{0};
+    std::size_t sqes_bytes_{0};
+    bool single_mmap_{false};
+
+    unsigned* sq_head_{nullptr};
+    unsigned* sq_tail_{nullptr};
+    unsigned* sq_array_{nullptr};
+    unsigned sq_mask_{0};
+    unsigned sq_entries_{0};
+    unsigned sq_local_tail_{0};
+
+    unsigned* cq_head_{nullptr};
+    unsigned* cq_tail_{nullptr};
+    io_uring_cqe* cqes_{nullptr};
+    unsigned cq_mask_{0};
+    unsigned cq_entries_{0};
+};
+
+} // namespace detail
+
+/// Asynchronous file I/O through io_uring with a blocking thread-pool fallback.
+/// Requests are queued by read/write/fsync and handed to the kernel in one batch by submit().
+/// Completion handlers take the result (bytes transferred or -errno) and run on the thread
+/// calling poll()/wait()/drain(). Handlers may queue further requests and may themselves call
+/// poll() or wait(). Not thread-safe: one owner thread per instance.
+class uring_file_io {
+public:
+    /// The most one read or write moves, as on Linux; longer requests complete short, like
+    /// pread and pwrite do, and the handler sees the bytes actually transferred
+    static constexpr std::size_t max_transfer = 0x7ffff000;
+
+    struct options {
+        unsigned queue_depth = 256;   // at least 1
+        unsigned fallback_threads = 4;
+        bool force_fallback = false;
+    };
+
+    uring_file_io() : uring_file_io(options{}) {}
+
+    explicit uring_file_io(options opts) {
+        if (opts.queue_depth == 0) { throw std::invalid_argument("uring_file_io: queue_depth must be positive"); }
+        if (!opts.force_fallback && ring_.open(opts.queue_depth)) {
+            uses_io_uring_ = true;
+            // The CQ can never overflow when in-flight requests are bounded by its size
+            slab_ = std::vector<detail::_Io_request>(ring_.cq_entries());
+        } else {
+            slab_ = std::vector<detail::_Io_request>(opts.queue_depth);
+            unsigned threads = opts.fallback_threads ? opts.fallback_threads : 1;
+            for (unsigned i = 0; i < threads; ++i) {
+                workers_.emplace_back([this] { worker_loop(); });
+            }
+        }
+        for (uint32_t i = 0; i < slab_.size(); ++i) { slab_[i].next_free = i + 1; }
+        free_head_ = 0;
+    }
+
+    uring_file_io(const uring_file_io&) = delete;
+    uring_file_io& operator=(const uring_file_io&) = delete;
+
+    ~uring_file_io() {
+        drain();
+        if (uses_io_uring_) {
+            ring_.close();
+        } else {
+            {
+                std::lock_guard lock(mutex_);
+                stopping_ = true;
+            }
+            work_cv_.notify_all();
+            for (auto& worker : workers_) { worker.join(); }
+        }
+    }
+
+    bool uses_io_uring() const noexcept { return uses_io_uring_; }
+    std::size_t in_flight() const noexcept { return in_flight_; }
+
+#ifdef ACPP_TASK_LATENCY
+    /// Queue delay (request queued to handler start, i.e. the I/O plus reaping) and handler run time
+    const task_latency& latency() const noexcept { return latency_; }
+#endif
+
+    // The source location is only used by ACPP_TRACE builds, to name the handler's task
+
+    template <typename Handler>
+    void read(int fd, void* buf, std::size_t len, off_t offset, Handler&& handler,
+              std::source_location location = std::source_location::current()) {
+        enqueue(detail::_Io_op::read, fd, buf, len, 0, offset, std::forward<Handler>(handler), location);
+    }
+
+    template <typename Handler>
+    void write(int fd, const void* buf, std::size_t len, off_t offset, Handler&& handler,
+               std::source_location location = std::source_location::current()) {
+        enqueue(detail::_Io_op::write, fd, const_cast<void*>(buf), len, 0, offset, std::forward<Handler>(handler),
+                location);
+    }
+
+    template <typename Handler>
+    void fsync(int fd, Handler&& handler, std::source_location location = std::source_location::current()) {
+        enqueue(detail::_Io_op::fsync, fd, nullptr, 0, 0, 0, std::forward<Handler>(handler), location);
+    }
+
+    /// Zero-copy read into a buffer previously passed to register_buffers()
+    template <typename Handler>
+    void read_fixed(int fd, unsigned buf_index, std::size_t len, off_t offset, Handler&& handler,
+                    std::source_location location = std::source_location::current()) {
+        check_fixed(buf_index, len);
+        enqueue(detail::_Io_op::read_fixed, fd, registered_[buf_index].iov_base, len, buf_index, offset,
+                std::forward<Handler>(handler), location);
+    }
+
+    template <typename Handler>
+    void write_fixed(int fd, unsigned buf_index, std::size_t len, off_t offset, Handler&& handler,
+                     std::source_location location = std::source_location::current()) {
+        check_fixed(buf_index, len);
+        enqueue(detail::_Io_op::write_fixed, fd, registered_[buf_index].iov_base, len, buf_index, offset,
+                std::forward<Handler>(handler), location);
+    }
+
+    /// Pins the buffers in the kernel so fixed reads/writes skip the per-call page mapping.
+    /// Returns 0 or -errno. The fallback just remembers them.
+    int register_buffers(std::span<const iovec> buffers) {
+        if (!registered_.empty()) { unregister_buffers(); }
+        if (uses_io_uring_) {
+            if (int ret = ring_.register_buffers(buffers); ret < 0) { return ret; }
+        }
+        registered_.assign(buffers.begin(), buffers.end());
+        return 0;
+    }
+
+    void unregister_buffers() {
+        if (uses_io_uring_ && !registered_.empty()) { ring_.unregister_buffers(); }
+        registered_.clear();
+    }
+
+    /// Hands every queued request to the kernel (or the pool) in one go. Returns the batch size.
+    unsigned submit() {
+        unsigned batch = std::exchange(queued_, 0);
+        if (batch == 0) { return 0; }
+        if (uses_io_uring_) {
+            check_enter(ring_.submit());
+        } else {
+            {
+                std::lock_guard lock(mutex_);
+                pending_.insert(pending_.end(), staged_.begin(), staged_.end());
+            }
+            staged_.clear();
+            batch > 1 ? work_cv_.notify_all() : work_cv_.notify_one();
+        }
+        return batch;
+    }
+
+    /// Runs the handlers of already finished requests without blocking
+    unsigned poll() { return reap(false); }
+
+    /// Submits, then blocks until at least one request finished and runs the handlers
+    unsigned wait() {
+        submit();
+        if (in_flight_ == 0) { return 0; }
+        return reap(true);
+    }
+
+    /// Blocks until nothing is in flight, including requests queued by handlers
+    void drain() {
+        while (in_flight_ != 0) { wait(); }
+    }
+
+private:
+    template <typename Handler>
+    void enqueue(detail::_Io_op op, int fd, void* buf, std::size_t len, unsigned buf_index, off_t offset,
+                 Handler&& handler, [[maybe_unused]] const std::source_location& location) {
+        while (free_head_ == slab_.size()) { wait(); }
+        uint32_t index = free_head_;
+        detail::_Io_request& request = slab_[index];
+        request.completion.set(std::forward<Handler>(handler));
+        free_head_ = request.next_free;
+        request.op = op;
+        request.fd = fd;
+        request.buf = buf;
+        request.len = static_cast<uint32_t>(std::min(len, max_transfer));
+        request.buf_index = static_cast<uint16_t>(buf_index);
+        request.offset = offset;
+#ifdef ACPP_TRACE
+        request.trace_id = 0;
+        if (trace::enabled()) [[unlikely]] {
+            request.trace_task = trace::task_of<std::decay_t<Handler>>(location);
+            request.trace_id = trace::enqueue(request.trace_task);
+        }
+#endif
+#ifdef ACPP_TASK_LATENCY
+        request.enqueued_ns = detail::_Latency_clock_ns();
+#endif
+        ++in_flight_;
+
+        try {
+            if (uses_io_uring_) {
+                io_uring_sqe* sqe = acquire_sqe();
+                prepare(*sqe, request);
+                sqe->user_data = index;
+            } else {
+                staged_.push_back(index);
+            }
+        } catch (...) {
+            // Nothing was queued: hand the slot back
+            --in_flight_;
+            request.completion.reset();
+            request.next_free = free_head_;
+            free_head_ = index;
+            throw;
+        }
+        ++queued_;
+    }
+
+    // A free SQE. When the SQ is full the queued ones are submitted; if the kernel takes only
+    // part of them, completions are reaped (running their handlers) until it takes the rest.
+    io_uring_sqe* acquire_sqe() {
+        while (true) {
+            if (io_uring_sqe* sqe = ring_.get_sqe()) { return sqe; }
+            submit();
+            if (io_uring_sqe* sqe = ring_.get_sqe()) { return sqe; }
+            reap(true);
+        }
+    }
+
+    static void check_enter(int ret) {
+        if (ret < 0) { throw std::runtime_error(std::string("io_uring_enter: ") + std::strerror(errno)); }
+    }
+
+    static void prepare(io_uring_sqe& sqe, const detail::_Io_request& request) noexcept {
+        sqe.fd = request.fd;
+        sqe.addr = reinterpret_cast<uint64_t>(request.buf);
+        sqe.len = request.len;
+        sqe.off = static_cast<uint64_t>(request.offset);
+        switch (request.op) {
+            case detail::_Io_op::read: sqe.opcode = IORING_OP_READ; break;
+            case detail::_Io_op::write: sqe.opcode = IORING_OP_WRITE; break;
+            case detail::_Io_op::fsync: sqe.opcode = IORING_OP_FSYNC; break;
+            case detail::_Io_op::read_fixed: sqe.opcode = IORING_OP_READ_FIXED; sqe.buf_index = request.buf_index; break;
+            case detail::_Io_op::write_fixed: sqe.opcode = IORING_OP_WRITE_FIXED; sqe.buf_index = request.buf_index; break;
+        }
+    }
+
+    void check_fixed(unsigned buf_index, std::size_t len) const {
+        if (buf_index >= registered_.size() || len > registered_[buf_index].iov_len) {
+            throw std::out_of_range("uring_file_io: bad registered buffer");
+        }
+    }
+
+    void complete(uint32_t index, int result) {
+        detail::_Io_request& request = slab_[index];
+        --in_flight_;
+        // Everything the handler run needs is moved out of the slot before it is recycled, so
+        // the handler can queue a follow-up request into the same slot
+        detail::_Completion completion(std::move(request.completion));
+#ifdef ACPP_TRACE
+        uint64_t trace_id = std::exchange(request.trace_id, 0);
+        trace::task_info trace_task = request.trace_task;
+#endif
+#ifdef ACPP_TASK_LATENCY
+        uint64_t started_ns = detail::_Latency_clock_ns();
+        latency_.queue_delay.record(started_ns - request.enqueued_ns);
+#endif
+        request.next_free = free_head_;
+        free_head_ = index;
+#ifdef ACPP_TRACE
+        if (trace_id) [[unlikely]] {
+            trace::start(trace_id, trace_task);
+            completion.invoke_and_reset(result);
+            trace::finish(trace_id, trace_task);
+        } else {
+            completion.invoke_and_reset(result);
+        }
+#else
+        completion.invoke_and_reset(result);
+#endif
+#ifdef ACPP_TASK_LATENCY
+        latency_.run_time.record(detail::_Latency_clock_ns() - started_ns);
+#endif
+    }
+
+    unsigned reap(bool block) {
+        if (uses_io_uring_) {
+            unsigned count = ring_.reap([this](uint64_t user_data, int res) {
+                complete(static_cast<uint32_t>(user_data), res);
+            });
+            if (count == 0 && block) {
+                check_enter(ring_.submit(1));
+                count = ring_.reap([this](uint64_t user_data, int res) {
+                    complete(static_cast<uint32_t>(user_data), res);
+                });
+            }
+            return count;
+        }
+        {
+            std::unique_lock lock(mutex_);
+            if (block && reaped_next_ == reaped_.size()) { done_cv_.wait(lock, [this] { return !done_.empty(); }); }
+            reaped_.insert(reaped_.end(), done_.begin(), done_.end());
+            done_.clear();
+        }
+        // Consumed through a member cursor, like the CQ head: a handler that polls or waits
+        // carries on with the rest of the batch instead of running it twice
+        unsigned count = 0;
+        while (reaped_next_ < reaped_.size()) {
+            auto [index, result] = reaped_[reaped_next_++];
+            complete(index, result);
+            ++count;
+        }
+        reaped_.clear();
+        reaped_next_ = 0;
+        return count;
+    }
+
+    // len is at most max_transfer, so the result fits an int
+    static int run_blocking(const detail::_Io_request& request) noexcept {
+        ssize_t ret = 0;
+        switch (request.op) {
+            case detail::_Io_op::read:
+            case detail::_Io_op::read_fixed:
+                ret = ::pread(request.fd, request.buf, request.len, request.offset); break;
+            case detail::_Io_op::write:
+            case detail::_Io_op::write_fixed:
+                ret = ::pwrite(request.fd, request.buf, request.len, request.offset); break;
+            case detail::_Io_op::fsync:
+                ret = ::fsync(request.fd); break;
+        }
+        return ret < 0 ? -errno : static_cast<int>(ret);
+    }
+
+    void worker_loop() {
+        std::unique_lock lock(mutex_);
+        while (true) {
+            work_cv_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+            if (pending_.empty()) { return; }
+            uint32_t index = pending_.front();
+            pending_.pop_front();
+            lock.unlock();
+            // The slot is owned by this worker until it shows up in done_
+            int result = run_blocking(slab_[index]);
+            lock.lock();
+            done_.emplace_back(index, result);
+            done_cv_.notify_one();
+        }
+    }
+
+private:
+    bool uses_io_uring_{false};
+    detail::_Uring ring_;
+    std::vector<detail::_Io_request> slab_;
+    uint32_t free_head_{0};
+    std::size_t in_flight_{0};
+    unsigned queued_{0};
+    std::vector<iovec> registered_;
+#ifdef ACPP_TASK_LATENCY
+    task_latency latency_;
+#endif
+
+    // Blocking fallback
+    std::vector<std::thread> workers_;
+    std::vector<uint32_t> staged_;
+    std::deque<uint32_t> pending_;
+    std::vector<std::pair<uint32_t, int>> done_;
+    std::vector<std::pair<uint32_t, int>> reaped_;
+    std::size_t reaped_next_{0};
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    bool stopping_{false};
+};
+
+} // namespace acpp
@@ -0,0 +1,197 @@
+#pragma once
+
+// Function over a closed set of callable types. The active callable lives in a buffer sized
+// for the largest one and is picked by a one-byte index; calls dispatch through an if-chain
+// on that index that the compiler turns into a jump table or a compare, with every
+// alternative's body visible for inlining. No vtable, no invoker pointer, no heap.
+//
+//     auto fast = [](int x) { return x * 2; };
+//     auto safe = [limit = 100](int x) { return std::min(x * 2, limit); };
+//     acpp::variant_function<int(int), decltype(fast), decltype(safe)> strategy = fast;
+//
+// to_function() turns the active callable into an acpp::function when it has to escape.
+//
+// Like std::variant, copy assignment copies in place when some callable type can throw on a
+// move; if that copy throws, the variant_function is left valueless_by_exception() and may
+// only be assigned to or destroyed.
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "function.h"
+
+namespace acpp {
+namespace detail {
+
+template <typename T, typename... Ts>
+constexpr std::size_t _Type_index() noexcept {
+    std::size_t index = 0;
+    bool found = false;
+    ((found = found || std::is_same_v<T, Ts>, index += found ? 0 : 1), ...);
+    return index;
+}
+
+template <typename T, typename... Ts>
+constexpr std::size_t _Type_count() noexcept {
+    return (std::size_t{0} + ... + (std::is_same_v<T, Ts> ? 1 : 0));
+}
+
+} // namespace detail
+
+template <typename Signature, typename... Callables>
+class variant_function;
+
+template <typename R, typename... Args, typename... Callables>
+class variant_function<R(Args...), Callables...> {
+private:
+    static_assert(sizeof...(Callables) > 0 && sizeof...(Callables) < 256, "1 to 255 callable types");
+    static_assert(((detail::_Type_count<Callables, Callables...>() == 1) && ...), "callable types must be distinct");
+    static_assert((std::is_same_v<Callables, std::decay_t<Callables>> && ...), "callable types must be decayed");
+    static_assert((std::is_invocable_r_v<R, Callables&, Args...> && ...), "every callable must match the signature");
+
+    template <typename F>
+    static constexpr std::size_t _Index = detail::_Type_index<F, Callables...>();
+
+    template <std::size_t I>
+    using _Alternative = std::tuple_element_t<I, std::tuple<Callables...>>;
+
+    // Never a valid index, as there are at most 255 callable types
+    static constexpr uint8_t _Valueless = 255;
+    static constexpr bool _Nothrow_move = (std::is_nothrow_move_constructible_v<Callables> && ...);
+
+public:
+    /// Holds the first callable, default constructed
+    variant_function() noexcept(std::is_nothrow_default_constructible_v<_Alternative<0>>)
+        requires std::default_initializable<_Alternative<0>> {
+        new (storage_) _Alternative<0>();
+    }
+
+    template <typename Callable>
+        requires (detail::_Type_count<std::decay_t<Callable>, Callables...>() == 1)
+    variant_function(Callable&& callable) : index_{static_cast<uint8_t>(_Index<std::decay_t<Callable>>)} {
+        new (storage_) std::decay_t<Callable>(std::forward<Callable>(callable));
+    }
+
+    variant_function(const variant_function& oth) requires (std::copy_constructible<Callables> && ...)
+        : index_{_Valueless} {
+        copy_from(oth);
+    }
+
+    variant_function(variant_function&& oth) noexcept(_Nothrow_move) : index_{oth.index_} {
+        if (valueless_by_exception()) { return; }
+        oth.visit_active([&]<std::size_t I>(std::integral_constant<std::size_t, I>) {
+            new (storage_) _Alternative<I>(std::move(oth.get<I>()));
+        });
+    }
+
+    variant_function& operator=(const variant_function& oth) requires (std::copy_constructible<Callables> && ...) {
+        if (this == &oth) { return *this; }
+        if constexpr (_Nothrow_move) {
+            // Copied aside first, so a throwing copy leaves this one untouched
+            variant_function copy(oth);
+            *this = std::move(copy);
+        } else {
+            destroy();
+            index_ = _Valueless;
+            copy_from(oth);
+        }
+        return *this;
+    }
+
+    // Requires nothrow moves, so a throwing move never leaves the variant without a callable
+    variant_function& operator=(variant_function&& oth) noexcept requires _Nothrow_move {
+        if (this != &oth) {
+            destroy();
+            index_ = oth.index_;
+            if (valueless_by_exception()) { return *this; }
+            oth.visit_active([&]<std::size_t I>(std::integral_constant<std::size_t, I>) {
+                new (storage_) _Alternative<I>(std::move(oth.get<I>()));
+            });
+        }
+        return *this;
+    }
+
+    ~variant_function() { destroy(); }
+
+    R operator()(Args... args) {
+        return visit_active([&]<std::size_t I>(std::integral_constant<std::size_t, I>) -> R {
+            return get<I>()(std::forward<Args>(args)...);
+        });
+    }
+
+    /// Position of the active callable in Callables
+    std::size_t index() const noexcept { return index_; }
+
+    /// True after a copy assignment threw; see the header comment
+    bool valueless_by_exception() const noexcept { return index_ == _Valueless; }
+
+    template <typename Callable>
+    bool holds() const noexcept { return index_ == _Index<Callable>; }
+
+    /// The active callable if it is a Callable, otherwise null
+    template <typename Callable>
+    Callable* get_if() noexcept { return holds<Callable>() ? &get<_Index<Callable>>() : nullptr; }
+
+    /// The active callable, stored directly in an acpp::function
+    template <typename Spill = heap_spill>
+    basic_function<R(Args...), Spill> to_function() const& {
+        return visit_active([&]<std::size_t I>(std::integral_constant<std::size_t, I>) {
+            return basic_function<R(Args...), Spill>(get<I>());
+        });
+    }
+
+    template <typename Spill = heap_spill>
+    basic_function<R(Args...), Spill> to_function() && {
+        return visit_active([&]<std::size_t I>(std::integral_constant<std::size_t, I>) {
+            return basic_function<R(Args...), Spill>(std::move(get<I>()));
+        });
+    }
+
+private:
+    template <std::size_t I>
+    _Alternative<I>& get() noexcept {
+        return *std::launder(reinterpret_cast<_Alternative<I>*>(storage_));
+    }
+    template <std::size_t I>
+    const _Alternative<I>& get() const noexcept {
+        return *std::launder(reinterpret_cast<const _Alternative<I>*>(storage_));
+    }
+
+    // Calls visitor with the active index as a constant. The last alternative needs no test.
+    template <std::size_t I = 0, typename Visitor>
+    decltype(auto) visit_active(Visitor&& visitor) const {
+        if constexpr (I + 1 == sizeof...(Callables)) {
+            return visitor(std::integral_constant<std::size_t, I>{});
+        } else {
+            if (index_ == I) { return visitor(std::integral_constant<std::size_t, I>{}); }
+            return visit_active<I + 1>(std::forward<Visitor>(visitor));
+        }
+    }
+
+    void destroy() noexcept {
+        if (valueless_by_exception()) { return; }
+        visit_active([&]<std::size_t I>(std::integral_constant<std::size_t, I>) { std::destroy_at(&get<I>()); });
+    }
+
+    // Into an empty, valueless this; the index is set once the copy has been constructed
+    void copy_from(const variant_function& oth) {
+        if (oth.valueless_by_exception()) { return; }
+        oth.visit_active([&]<std::size_t I>(std::integral_constant<std::size_t, I>) {
+            new (storage_) _Alternative<I>(oth.get<I>());
+        });
+        index_ = oth.index_;
+    }
+
+private:
+    alignas(Callables...) std::byte storage_[std::max({sizeof(Callables)...})];
+    uint8_t index_{0};
+};
+
+} // namespace acpp